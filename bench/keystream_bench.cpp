@@ -0,0 +1,73 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "cryption/keystream.h"
+
+// 比较KeystreamCipher单线程和多线程的吞吐，用于确定并行的阈值
+//
+//     keystream_bench [线程数]
+namespace
+{
+    struct Algorithm
+    {
+        const char *name;
+        CipherAlgorithm algorithm;
+    };
+
+    const Algorithm ALGORITHMS[] = {
+        {"ChaCha20", CipherAlgorithm::ChaCha20},
+        {"AES256OFB", CipherAlgorithm::AES256OFB},
+        {"SM4OFB", CipherAlgorithm::SM4OFB},
+    };
+
+    // 重复运算直到累计至少256MiB，返回MB/s
+    double measure(const KeystreamCipher &cipher, std::vector<uint8_t> &data)
+    {
+        const uint8_t iv[16] = {};
+        size_t repeat = std::max<size_t>(1, (256 << 20) / data.size());
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < repeat; i++)
+        {
+            if (!cipher.apply(iv, data.data(), data.size()))
+            {
+                return 0;
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return (double)data.size() * repeat / elapsed.count() / 1e6;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+    threads = std::max<size_t>(threads, 2);
+    uint8_t key[32];
+    std::mt19937 rng(1);
+    for (auto &b : key)
+    {
+        b = (uint8_t)rng();
+    }
+    std::printf("%-10s %10s %14s %14s\n", "算法", "长度KiB", "单线程MB/s", "多线程MB/s");
+    for (const auto &algorithm : ALGORITHMS)
+    {
+        if (!KeystreamCipher::is_supported(algorithm.algorithm))
+        {
+            continue;
+        }
+        KeystreamCipher sequential(algorithm.algorithm, key, 1);
+        KeystreamCipher parallel(algorithm.algorithm, key, threads);
+        for (size_t len = 64 * 1024; len <= 16 * 1024 * 1024; len *= 2)
+        {
+            std::vector<uint8_t> data(len);
+            std::printf("%-10s %10zu %14.0f %14.0f\n", algorithm.name, len / 1024,
+                        measure(sequential, data), measure(parallel, data));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <openssl/evp.h>
+#include <ciftl/etc/etc.h>
+
+#include "etc/text_codec.h"
+
+// 测量十六进制和Base64编解码的吞吐，结果按二进制数据的长度计算，编码包括分配输出的开销
+//
+//     CIFTL_TEXT_CODEC=scalar text_codec_bench
+// 分别以scalar、ssse3和不设置该变量运行，比较各级实现。
+// 基准行：ciftl::HexEncoding是哈希工具原来使用的编码器；ciftl的Base64在StringCrypter内部，
+// 无法单独调用，以OpenSSL的EVP_EncodeBlock/EVP_DecodeBlock作为标量Base64的参照
+namespace
+{
+    constexpr size_t DATA_SIZE = 64 * 1024 * 1024;
+    constexpr int REPEAT = 8;
+
+    template <typename F>
+    double measure(F func)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < REPEAT; i++)
+        {
+            if (!func())
+            {
+                return 0;
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return (double)DATA_SIZE * REPEAT / elapsed.count() / 1e9;
+    }
+}
+
+int main()
+{
+    std::vector<uint8_t> data(DATA_SIZE);
+    std::mt19937 rng(1);
+    for (auto &b : data)
+    {
+        b = (uint8_t)rng();
+    }
+    std::string hex = HexCodec::encode(data);
+    std::string base64 = Base64Codec::encode(data);
+    std::vector<uint8_t> out;
+    std::string text;
+    ciftl::HexEncoding ciftl_hex;
+    std::printf("基准\n");
+    std::printf("ciftl hex encode      %.2f GB/s\n", measure([&]()
+                                                        { return ciftl_hex.encode(data).size() == hex.size(); }));
+    std::printf("openssl base64 encode %.2f GB/s\n", measure([&]()
+                                                         {
+        text.assign(base64.size() + 1, '\0');
+        return EVP_EncodeBlock((unsigned char *)text.data(), data.data(), (int)data.size()) == (int)base64.size(); }));
+    std::printf("openssl base64 decode %.2f GB/s\n", measure([&]()
+                                                         {
+        out.resize(base64.size() / 4 * 3);
+        return EVP_DecodeBlock(out.data(), (const unsigned char *)base64.data(), (int)base64.size()) ==
+               (int)out.size(); }));
+    std::printf("实现：%s\n", text_codec_level());
+    std::printf("hex encode    %.2f GB/s\n", measure([&]()
+                                                   { return HexCodec::encode(data).size() == hex.size(); }));
+    std::printf("hex decode    %.2f GB/s\n", measure([&]()
+                                                   { return HexCodec::decode(hex, out) && out.size() == data.size(); }));
+    std::printf("base64 encode %.2f GB/s\n", measure([&]()
+                                                   { return Base64Codec::encode(data).size() == base64.size(); }));
+    std::printf("base64 decode %.2f GB/s\n", measure([&]()
+                                                   { return Base64Codec::decode(base64, out) && out.size() == data.size(); }));
+    return 0;
+}
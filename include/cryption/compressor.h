@@ -0,0 +1,54 @@
+#ifndef COMPRESSOR_H
+#define COMPRESSOR_H
+#include <string>
+#include <vector>
+#include <cstdint>
+
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+struct ZSTD_CDict_s;
+struct ZSTD_DDict_s;
+
+// zstd压缩，每个实例只能在一个线程中使用
+//
+// 压缩结果是完整的zstd帧，帧头记录了原文长度和所用字典的ID，解压时不需要额外的信息。
+// 字典可以用train_dictionary从大量相似的小样本中训练得到，对几百字节的短文本效果明显。
+class Compressor
+{
+public:
+    explicit Compressor(int level = __default_level__, const std::string &dictionary = "");
+    ~Compressor();
+    Compressor(const Compressor &) = delete;
+    Compressor &operator=(const Compressor &) = delete;
+
+public:
+    // 压缩后不比原文短时返回false，调用方应保存原文
+    bool compress(const uint8_t *data, size_t len, std::string &out);
+    // 解压一个完整的帧，原文长度超过max_size时视为错误
+    bool decompress(const uint8_t *data, size_t len, size_t max_size, std::string &out, std::string &message);
+    // 字典的ID，没有字典时为0
+    uint32_t dictionary_id() const;
+
+public:
+    // 从样本中训练字典，失败时返回空字符串并在message中给出原因
+    static std::string train_dictionary(const std::vector<std::string> &samples, size_t capacity, std::string &message);
+    // 检查字典能否使用。只接受带有ID的zstd格式字典：没有ID的原始内容字典压缩出的帧头中不记录字典，
+    // 解压时无法区分是否需要字典
+    static bool check_dictionary(const std::string &dictionary, std::string &message);
+
+private:
+    int m_level;
+    uint32_t m_dictionary_id = 0;
+    ZSTD_CCtx_s *m_cctx = nullptr;
+    ZSTD_DCtx_s *m_dctx = nullptr;
+    ZSTD_CDict_s *m_cdict = nullptr;
+    ZSTD_DDict_s *m_ddict = nullptr;
+
+public:
+    constexpr static int __min_level__ = 1;
+    constexpr static int __max_level__ = 19;
+    constexpr static int __default_level__ = 3;
+    constexpr static size_t __default_dictionary_capacity__ = 64 * 1024;
+};
+
+#endif // COMPRESSOR_H
@@ -1,11 +1,13 @@
 #ifndef CRYPTER_FORM_H
 #define CRYPTER_FORM_H
+#include <thread>
 
 #include <QWidget>
 #include <QAbstractTableModel>
 
 #include <ciftl/crypter/crypter.h>
 
+#include "cryption/string_pipeline.h"
 #include "etc/line_importer.h"
 #include "etc/type.h"
 
@@ -16,15 +18,6 @@ namespace Ui
     class CrypterForm;
 }
 
-enum class CipherAlgorithm
-{
-    ChaCha20,
-    AES128OFB,
-    AES192OFB,
-    AES256OFB,
-    SM4OFB,
-};
-
 class LineImorter;
 
 class CrypterTableDataModel : public QAbstractTableModel
@@ -156,6 +149,13 @@ public:
 private:
     void refresh_table();
     void restrict_table();
+    void do_file_cryption(CryptionMode mode);
+    StringCompressOption compress_option();
+
+signals:
+    void file_operation_start();
+    void file_operation_end(QString message);
+    void file_progress_update(QString message);
 
 private slots:
     void update_table(std::vector<CrypterTableData> data);
@@ -165,6 +165,13 @@ private slots:
     void copy_result();
     void encrypt();
     void decrypt();
+    void encrypt_file();
+    void decrypt_file();
+    void load_dictionary();
+    void train_dictionary();
+    void start_file_operation();
+    void end_file_operation(QString message);
+    void update_file_progress(QString message);
 
 private:
     Ui::CrypterForm *ui;
@@ -172,6 +179,9 @@ private:
 private:
     MainWindow *m_parent_widget;
     LineImporter *m_line_importer;
+    std::unique_ptr<std::thread> m_file_thread;
+    // 当前使用的zstd字典，为空表示不使用字典
+    std::string m_dictionary;
 
 public:
     const static std::vector<std::pair<std::string, CipherAlgorithm>> __supported_cipher_algorithm__;
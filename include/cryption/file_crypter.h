@@ -0,0 +1,104 @@
+#ifndef FILE_CRYPTER_H
+#define FILE_CRYPTER_H
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "etc/type.h"
+
+// 文件加密的容器格式（所有整数均为小端序）：
+//
+//   文件头 (92 Bytes)
+//     magic[8]            "CIFTLENC"
+//     version u8          容器版本，未压缩为1，压缩为2
+//     algorithm u8        CipherAlgorithm
+//     flags u16           第0位表示数据块经过压缩
+//     chunk_size u32      每块明文长度
+//     kdf_iterations u32  PBKDF2-HMAC-SHA256迭代次数，不超过__max_kdf_iterations__
+//     salt[16]            密钥派生的盐
+//     nonce[16]           文件级随机数，每块的IV由它和块序号派生
+//     plain_size u64      明文总长度
+//     header_mac[32]      HMAC-SHA256(mac_key, 以上全部字段)
+//   数据块 * N
+//     cipher_text[chunk_size]（最后一块可能更短）
+//     tag[32]             HMAC-SHA256(mac_key, header_mac || index u64 || is_last u8 || cipher_text)
+//
+// 每块在文件中的位置可以直接由序号计算，因此可以只解密任意一段字节而不处理整个文件。
+//
+// 压缩容器中每块先用zstd压缩再加密，数据块变为：
+//     stored u32          最高位表示该块经过压缩，其余位为密文长度；压缩没有收益的块保存原文
+//     cipher_text[stored & 0x7fffffff]
+//     tag[32]             HMAC-SHA256(mac_key, header_mac || index u64 || is_last u8 || stored u32 || cipher_text)
+//   块偏移索引（最后一块之后）
+//     offset u64 * N      每块的stored字段在容器中的偏移，N为块数
+// 块的长度不固定，解密一段时从索引中查出起始块的位置。索引不单独认证：偏移错误时读到的块无法通过认证，
+// 完整解密时还会与实际偏移逐一比较。
+
+// 文件加密的选项
+struct FileCrypterOption
+{
+    // 加密算法，解密时以文件头中记录的算法为准
+    CipherAlgorithm algorithm = CipherAlgorithm::ChaCha20;
+    // 每块明文的长度
+    size_t chunk_size = 1024 * 1024;
+    // 并行处理的线程数，0表示使用全部核心
+    size_t thread_count = 0;
+    // 加密前先压缩每块，解密时以文件头中记录的格式为准
+    bool compress = false;
+    int compress_level = 3;
+};
+
+// 文件加密的结果
+struct FileCrypterResult
+{
+    bool ok = true;
+    std::string message;
+
+    static FileCrypterResult success()
+    {
+        return {true, ""};
+    }
+
+    static FileCrypterResult failure(const std::string &message)
+    {
+        return {false, message};
+    }
+};
+
+// 进度回调，参数为已处理和总共的明文字节数
+using FileCrypterProgress = std::function<void(uint64_t done, uint64_t total)>;
+
+// 分块的流式文件加密器，内存占用只和块大小与线程数有关
+class FileCrypter
+{
+public:
+    explicit FileCrypter(const std::string &password, const FileCrypterOption &option = FileCrypterOption());
+
+public:
+    FileCrypterResult encrypt_file(const std::string &src_path, const std::string &dst_path,
+                                   const FileCrypterProgress &progress = nullptr);
+    FileCrypterResult decrypt_file(const std::string &src_path, const std::string &dst_path,
+                                   const FileCrypterProgress &progress = nullptr);
+    // 只解密明文中[offset, offset + length)这一段，所有覆盖该段的数据块都通过认证后才写入out
+    FileCrypterResult decrypt_range(const std::string &src_path, uint64_t offset, uint64_t length,
+                                    std::vector<uint8_t> &out);
+
+private:
+    size_t thread_count() const;
+
+private:
+    std::string m_password;
+    FileCrypterOption m_option;
+
+public:
+    constexpr static uint8_t __container_version__ = 1;
+    constexpr static uint8_t __compressed_container_version__ = 2;
+    constexpr static uint32_t __kdf_iterations__ = 200000;
+    // 文件头在认证之前就决定了密钥派生的开销，超过上限的文件直接拒绝
+    constexpr static uint32_t __max_kdf_iterations__ = __kdf_iterations__ * 4;
+    constexpr static size_t __min_chunk_size__ = 4 * 1024;
+    constexpr static size_t __max_chunk_size__ = 64 * 1024 * 1024;
+};
+
+#endif // FILE_CRYPTER_H
@@ -1,5 +1,6 @@
 #ifndef HASH_FORM_H
 #define HASH_FORM_H
+#include <memory>
 #include <thread>
 
 #include <QWidget>
@@ -10,6 +11,12 @@
 #include <ciftl/hash/hash.h>
 #include <ciftl/etc/etc.h>
 
+#include "etc/job_queue.h"
+#include "io/file_reader.h"
+#include "io/hash_manifest.h"
+#include "io/folder_watcher.h"
+#include "service/hash_client.h"
+
 namespace Ui
 {
     class HashForm;
@@ -24,7 +31,28 @@ public:
     ~HashForm();
 
 private:
-    std::vector<std::pair<std::string, std::shared_ptr<ciftl::IHasher>>> generate_hasher_vec();
+    std::vector<std::string> checked_hasher_names();
+    FileReadOption checked_read_option();
+    // 计算文件的各个摘要，以十六进制保存在digests中
+    FileReadStatus digest_file(FileReader &reader, JobControl &control, const std::vector<std::string> &hasher_names,
+                               const std::string &file_path, size_t file_size,
+                               std::vector<std::pair<std::string, std::string>> &digests);
+    QStringList result_lines(const QString &q_file_path, uint64_t file_size, FileReadStatus status,
+                             const std::vector<std::pair<std::string, std::string>> &digests, bool shared,
+                             const std::string &note);
+    QStringList hash_file(FileReader &reader, JobControl &control, const std::vector<std::string> &hasher_names,
+                          const QString &q_file_path, const std::string &file_path);
+    // 通过守护进程校验，结果的输出与本地计算相同
+    void hash_by_daemon(HashClient &client, JobControl &control, const QStringList &file_paths,
+                        const std::vector<std::string> &local_paths, const FileReadOption &read_option,
+                        const std::vector<std::string> &hasher_names);
+    // 在监视线程中运行，直到stop_watch
+    void watch_folder(const std::string &root, const FileReadOption &read_option,
+                      const std::vector<std::string> &hasher_names);
+    // 把一批变化的文件作为一个任务提交，在任务中重新计算并更新清单
+    void submit_watch_job(const std::shared_ptr<HashManifest> &manifest, const std::vector<std::string> &paths,
+                          const FileReadOption &read_option, const std::vector<std::string> &hasher_names);
+    void stop_watch();
 
 protected:
     void dragEnterEvent(QDragEnterEvent *event) override
@@ -56,6 +84,7 @@ signals:
     void file_progress_update(size_t val);
     void total_progress_update(size_t val);
     void main_text_update(QString val);
+    void watch_end(size_t generation);
 
 private slots:
     void start_operation();
@@ -68,11 +97,28 @@ private slots:
     void copy_result();
     void save_as();
     void choose_files();
+    void pause_or_resume();
+    void cancel_all();
+    void start_or_stop_watch();
+    void update_rate_limit(int val);
+    void end_watch(size_t generation);
     void do_hash(QStringList file_paths);
 
 private:
     Ui::HashForm *ui;
-    std::unique_ptr<std::thread> m_thread;
+    std::unique_ptr<JobQueue> m_job_queue;
+    // 窗口中所有读取共享的限速器
+    std::shared_ptr<RateLimiter> m_rate_limiter;
+    // 尚未结束的任务数，只在界面线程中访问
+    size_t m_job_count = 0;
+    // 监视文件夹，监视线程退出前一直有效
+    std::unique_ptr<FolderWatcher> m_folder_watcher;
+    std::unique_ptr<std::thread> m_watch_thread;
+    // 每次开始监视加一，监视线程结束时带上自己的编号，过时的结束信号不影响新的监视
+    size_t m_watch_generation = 0;
+
+public:
+    const static std::vector<std::pair<std::string, FileReadMode>> __supported_read_mode__;
 };
 
 #endif // HASH_FORM_H
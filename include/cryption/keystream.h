@@ -0,0 +1,57 @@
+#ifndef KEYSTREAM_H
+#define KEYSTREAM_H
+#include <cstdint>
+#include <cstddef>
+
+#include "etc/type.h"
+
+// 对大块输入的流密码运算
+//
+// ChaCha20：密钥流的每64字节由块计数器独立生成，按计数器把输入切成若干段交给多个线程，
+//   每段内部仍由OpenSSL的SSSE3/AVX2/AVX-512实现按多个SIMD通道并行生成。
+// OFB：下一块密钥流依赖上一块，无法并行，改为由生产者线程提前生成密钥流，
+//   调用线程只负责异或，两者流水线重叠。
+//
+// 多线程部分由进程内共用的常驻线程池执行，调用线程也参与计算。
+// 输入小于阈值时直接走单线程路径，每个ChaCha20线程至少分到__chacha20_min_segment__字节，
+// 使交给线程池的开销远小于每段的计算量。OFB流水线的收益上限是异或在总耗时中的占比。
+//
+// 字符串加密由ciftl的StringCrypter完成，密文格式（密钥派生、IV和编码）由ciftl决定，
+// 因此只有文件加密经过这里。
+class KeystreamCipher
+{
+public:
+    // key的长度由算法决定，thread_count为0表示使用全部核心
+    KeystreamCipher(CipherAlgorithm algorithm, const uint8_t *key, size_t thread_count = 0);
+
+public:
+    static bool is_supported(CipherAlgorithm algorithm);
+    // 使用16字节的iv对data原地加/解密
+    bool apply(const uint8_t *iv, uint8_t *data, size_t len) const;
+
+private:
+    bool apply_sequential(const uint8_t *iv, uint8_t *data, size_t len) const;
+    bool apply_chacha20_parallel(const uint8_t *iv, uint8_t *data, size_t len) const;
+    bool apply_ofb_pipelined(const uint8_t *iv, uint8_t *data, size_t len) const;
+
+private:
+    CipherAlgorithm m_algorithm;
+    const uint8_t *m_key;
+    size_t m_thread_count;
+
+public:
+    // bench/keystream_bench.cpp的实测值，单线程/2个线程，MB/s
+    // （Intel Xeon虚拟机，1个核心，AVX2和AVX-512，OpenSSL 3.0.17）：
+    //   ChaCha20   128 KiB 3545/3521（低于阈值）  256 KiB 3540/2939  1 MiB 3778/3698   16 MiB 3647/3570
+    //   AES256OFB  512 KiB 718/714（低于阈值）   1 MiB 738/534       16 MiB 727/535
+    //   SM4OFB     512 KiB 71/69（低于阈值）     1 MiB 72/65         16 MiB 68/72
+    // 单核机器测不出交叉点，只能看到开销：ChaCha20交给线程池的开销在测量误差以内，
+    // OFB的生产者与调用线程争用同一个核心，慢约27%。默认线程数取核心数，单核机器始终走单线程路径。
+    // 以下阈值是按多核机器推算的，需要在多核机器上用同一个程序复核。
+    constexpr static size_t __chacha20_parallel_threshold__ = 256 * 1024;
+    constexpr static size_t __chacha20_min_segment__ = 64 * 1024;
+    constexpr static size_t __ofb_pipeline_threshold__ = 1024 * 1024;
+    constexpr static size_t __ofb_pipeline_slot__ = 64 * 1024;
+};
+
+#endif // KEYSTREAM_H
@@ -0,0 +1,57 @@
+#ifndef STRING_PIPELINE_H
+#define STRING_PIPELINE_H
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include <ciftl/crypter/crypter.h>
+
+#include "etc/type.h"
+
+// 字符串压缩的选项
+struct StringCompressOption
+{
+    bool enabled = false;
+    int level = 3;
+    // zstd字典，为空表示不使用字典。解密带字典压缩的密文时必须提供同一个字典
+    std::string dictionary;
+};
+
+using StringCrypterFactory = std::function<std::shared_ptr<ciftl::IStringCrypter>()>;
+
+// 批量字符串的压缩-加密流水线
+//
+// 压缩后的密文为"zstd:" + StringCrypter对zstd帧加密的密文，解密时根据前缀自动解压，没有前缀的密文按原样解密。
+// 帧直接作为StringCrypter的输入，只在输出密文时编码一次。
+// 压缩后没有收益的行（通常是很短的文本）不压缩，也不加前缀。
+// 压缩和加密（解密和解压）是两个阶段，各自在独立的线程中处理，前一阶段处理完一行后下一阶段立即开始处理该行。
+class StringPipeline
+{
+public:
+    StringPipeline(const StringCrypterFactory &crypter_factory, const std::string &password,
+                   const StringCompressOption &option = StringCompressOption(), size_t thread_count = 0);
+
+public:
+    void encrypt(std::vector<CrypterTableData> &rows);
+    void decrypt(std::vector<CrypterTableData> &rows);
+
+private:
+    // 每个线程调用一次，返回该线程处理一行的函数，线程私有的压缩器和加密器在其中创建
+    using StageFactory = std::function<std::function<void(size_t index)>()>;
+    // 第一阶段处理完第i行后第二阶段才会处理第i行
+    void run(size_t count, const StageFactory &first_stage, const StageFactory &second_stage);
+
+private:
+    StringCrypterFactory m_crypter_factory;
+    std::string m_password;
+    StringCompressOption m_option;
+    size_t m_thread_count;
+
+public:
+    constexpr static const char *__compressed_prefix__ = "zstd:";
+    // 解压后的最大长度，防止损坏或恶意的密文占用过多内存
+    constexpr static size_t __max_plain_size__ = 256 * 1024 * 1024;
+};
+
+#endif // STRING_PIPELINE_H
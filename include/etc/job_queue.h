@@ -0,0 +1,91 @@
+#ifndef JOB_QUEUE_H
+#define JOB_QUEUE_H
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+// 任务的优先级
+enum class JobPriority
+{
+    // 紧急任务有专用的工作线程，运行期间普通任务在检查点处让出
+    URGENT,
+    NORMAL,
+};
+
+class JobQueue;
+
+// 单个任务的控制句柄
+class JobControl
+{
+    friend class JobQueue;
+
+public:
+    JobControl(JobQueue *queue, JobPriority priority);
+
+public:
+    void cancel();
+    bool cancelled() const;
+    JobPriority priority() const;
+    // 在任务中每处理完一块数据调用一次：暂停或需要让出时阻塞，已取消时返回false
+    bool checkpoint();
+
+private:
+    JobQueue *m_queue;
+    JobPriority m_priority;
+    std::atomic<bool> m_cancelled;
+};
+
+using JobTask = std::function<void(JobControl &control)>;
+
+// 复用工作线程的任务队列
+//
+// 同一优先级内先进先出，紧急任务总是先于普通任务开始。已取消的任务仍会被调度执行一次，
+// 由任务自己在第一个检查点处返回并完成收尾，调用方因此总能收到任务结束的通知。
+class JobQueue
+{
+    friend class JobControl;
+
+public:
+    // worker_count为普通工作线程数，另有一个线程只执行紧急任务
+    explicit JobQueue(size_t worker_count = 1);
+    ~JobQueue();
+
+public:
+    std::shared_ptr<JobControl> submit(JobTask task, JobPriority priority = JobPriority::NORMAL);
+    // 暂停后排队的任务不会开始，运行中的任务在下一个检查点处阻塞
+    void pause();
+    void resume();
+    bool paused() const;
+    // 取消排队和运行中的所有任务，同时解除暂停
+    void cancel_all();
+
+private:
+    struct Job
+    {
+        std::shared_ptr<JobControl> control;
+        JobTask task;
+    };
+
+    void worker_loop(bool urgent_only);
+    bool wait_runnable(const JobControl &control);
+    void notify();
+
+private:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<Job> m_urgent_jobs;
+    std::deque<Job> m_normal_jobs;
+    std::vector<std::shared_ptr<JobControl>> m_running;
+    // 排队和运行中的紧急任务数
+    size_t m_urgent_active = 0;
+    bool m_paused = false;
+    bool m_stopping = false;
+    std::vector<std::thread> m_workers;
+};
+
+#endif // JOB_QUEUE_H
@@ -0,0 +1,14 @@
+#ifndef LOCAL_PATH_H
+#define LOCAL_PATH_H
+#include <string>
+
+#include <QString>
+
+// 把界面上的路径转换为本地编码，供标准库的文件接口使用
+inline std::string to_local_path(const QString &str)
+{
+    auto local_8bit = str.toLocal8Bit();
+    return std::string(local_8bit.constData(), local_8bit.size());
+}
+
+#endif // LOCAL_PATH_H
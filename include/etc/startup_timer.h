@@ -0,0 +1,16 @@
+#ifndef STARTUP_TIMER_H
+#define STARTUP_TIMER_H
+
+// 启动各阶段的耗时统计
+//
+// 设置环境变量CIFTL_STARTUP_TIMING后，每个阶段结束时向标准错误输出
+// 从进程启动计时开始的累计时间和该阶段的耗时，未设置时不输出任何内容。
+class StartupTimer
+{
+public:
+    // 在main的第一行调用
+    static void start();
+    static void mark(const char *phase);
+};
+
+#endif // STARTUP_TIMER_H
@@ -0,0 +1,48 @@
+#ifndef TEXT_CODEC_H
+#define TEXT_CODEC_H
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+// 向量化的十六进制和Base64编解码
+//
+// 首次调用时按CPU能力选择实现：x86-64上依次尝试AVX2和SSSE3，
+// AArch64上十六进制使用NEON，其余情况使用标量实现。各实现的输出完全一致：
+// 十六进制为小写，Base64为带'='填充的标准字母表。
+// 设置环境变量CIFTL_TEXT_CODEC为"scalar"或"ssse3"可以限制使用的实现。
+
+// 十六进制编码
+class HexCodec
+{
+public:
+    static std::string encode(const uint8_t *data, size_t len);
+    // 长度为奇数或含有非法字符时返回false，大小写均可
+    static bool decode(std::string_view text, std::vector<uint8_t> &out);
+
+    template <typename T>
+    static std::string encode(const T &bytes)
+    {
+        return encode((const uint8_t *)bytes.data(), bytes.size());
+    }
+};
+
+// Base64编码
+class Base64Codec
+{
+public:
+    static std::string encode(const uint8_t *data, size_t len);
+    // 长度不是4的倍数、填充错误或含有非法字符时返回false
+    static bool decode(std::string_view text, std::vector<uint8_t> &out);
+
+    template <typename T>
+    static std::string encode(const T &bytes)
+    {
+        return encode((const uint8_t *)bytes.data(), bytes.size());
+    }
+};
+
+// 当前选择的实现名称，如"avx2"、"ssse3"、"neon"、"scalar"
+const char *text_codec_level();
+
+#endif // TEXT_CODEC_H
@@ -0,0 +1,26 @@
+#ifndef THEME_LOADER_H
+#define THEME_LOADER_H
+#include <string>
+#include <vector>
+
+#include <QString>
+
+// 按需加载的界面主题
+//
+// 主题的样式表和图片打包在程序目录下的qss.rcc中，只有第一次切换主题时才注册到资源系统，
+// 默认界面使用的flatwhite图片仍然编译在程序中。
+class ThemeLoader
+{
+public:
+    // 读取主题name的样式表，失败时返回false并在message中给出原因
+    static bool load(const QString &name, QString &style_sheet, QString &message);
+
+private:
+    static bool register_resource(QString &message);
+
+public:
+    // 菜单显示的名称和主题名，主题名为空表示mainwindow.ui中的默认样式
+    const static std::vector<std::pair<std::string, std::string>> __supported_theme__;
+};
+
+#endif // THEME_LOADER_H
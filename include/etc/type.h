@@ -2,6 +2,16 @@
 #define TYPE_H
 #include <string>
 
+// 加密算法
+enum class CipherAlgorithm
+{
+    ChaCha20,
+    AES128OFB,
+    AES192OFB,
+    AES256OFB,
+    SM4OFB,
+};
+
 // 加密器的表格数据
 struct CrypterTableData
 {
@@ -0,0 +1,119 @@
+#ifndef FILE_READER_H
+#define FILE_READER_H
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+// 文件读取方式
+enum class FileReadMode
+{
+    // std::ifstream缓冲读取
+    BUFFERED,
+    // 顺序读取，并通过posix_fadvise丢弃读指针之后的页缓存
+    BULK_SCAN,
+    // O_DIRECT绕过页缓存，使用对齐的缓冲区
+    DIRECT,
+    // io_uring异步读取，同时保持多个读请求，不可用时退回到BUFFERED
+    ASYNC,
+};
+
+// 文件读取的结果
+enum class FileReadStatus
+{
+    OK,
+    OPEN_FAILED,
+    READ_FAILED,
+    CANCELLED,
+};
+
+// 令牌桶限速器，可以被多个读取器共享
+class RateLimiter
+{
+public:
+    // bytes_per_second为0表示不限速
+    explicit RateLimiter(uint64_t bytes_per_second);
+
+public:
+    // 消耗bytes个令牌，令牌不足时阻塞。等待期间每__cancel_check_interval__检查一次cancelled，
+    // 取消时退还没有等完的令牌并返回false
+    bool acquire(size_t bytes, const std::function<bool()> &cancelled = nullptr);
+    uint64_t rate() const;
+    // 修改速度，共享该限速器的读取器从下一块开始生效
+    void set_rate(uint64_t bytes_per_second);
+
+private:
+    std::mutex m_mutex;
+    std::atomic<uint64_t> m_rate;
+    double m_tokens;
+    std::chrono::steady_clock::time_point m_last;
+
+public:
+    // 限速等待时检查取消的间隔
+    constexpr static std::chrono::milliseconds __cancel_check_interval__{100};
+};
+
+// 文件读取的选项
+struct FileReadOption
+{
+    FileReadMode mode = FileReadMode::BUFFERED;
+    // 每次读取的块大小，DIRECT模式下会向上对齐
+    size_t block_size = 1024 * 1024 * 32;
+    // 共享的限速器，为空表示不限速
+    std::shared_ptr<RateLimiter> rate_limiter;
+    // 限速等待期间检查，返回true时停止读取并返回CANCELLED，为空表示只能通过回调取消
+    std::function<bool()> cancelled;
+};
+
+// 每读取一块调用一次，返回false时停止读取
+using FileBlockHandler = std::function<bool(const uint8_t *data, size_t len)>;
+
+class UringQueue;
+
+// 按块读取整个文件，同一个读取器的缓冲区在多个文件之间复用
+class FileReader
+{
+public:
+    explicit FileReader(const FileReadOption &option = FileReadOption());
+    ~FileReader();
+
+public:
+    FileReadStatus read(const std::string &file_path, const FileBlockHandler &handler);
+    // 告知下一次read将要读取的文件，ASYNC模式下在当前文件的读请求都提交后开始预读，空字符串表示没有
+    void prefetch(const std::string &file_path);
+    // 读取方式的降级说明，例如异步读取不可用而改用了缓冲读取，没有降级时为空
+    std::string note() const;
+
+private:
+    FileReadStatus read_buffered(const std::string &file_path, const FileBlockHandler &handler);
+#ifdef __linux__
+    FileReadStatus read_posix(const std::string &file_path, bool direct, const FileBlockHandler &handler);
+    FileReadStatus read_async(const std::string &file_path, const FileBlockHandler &handler);
+    void drop_prefetch();
+#endif
+    uint8_t *buffer();
+
+private:
+    FileReadOption m_option;
+    uint8_t *m_buffer = nullptr;
+    std::unique_ptr<UringQueue> m_uring;
+    bool m_uring_unavailable = false;
+    // 下一个文件，以及已经打开并交给队列预读的文件
+    std::string m_prefetch_path;
+    std::string m_next_path;
+    int m_next_fd = -1;
+    uint64_t m_next_size = 0;
+
+public:
+    // O_DIRECT要求的缓冲区、偏移和长度对齐
+    constexpr static size_t __direct_alignment__ = 4096;
+    // ASYNC模式同时在途的读请求数和每个请求的大小
+    constexpr static size_t __async_queue_depth__ = 32;
+    constexpr static size_t __async_block_size__ = 512 * 1024;
+};
+
+#endif // FILE_READER_H
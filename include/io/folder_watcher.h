@@ -0,0 +1,78 @@
+#ifndef FOLDER_WATCHER_H
+#define FOLDER_WATCHER_H
+#include <set>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// 目录树中的变化
+enum class FileChangeKind
+{
+    // 文件被创建、修改或修改了元数据，写入已经停止了一段时间
+    MODIFIED,
+    // 文件或目录被删除或移出目录树，目录被删除时其下所有文件都视为删除
+    REMOVED,
+    // 事件队列溢出，丢失了部分事件，调用方需要重新扫描整个目录树
+    RESCAN,
+};
+
+struct FileChange
+{
+    // 相对于根目录的路径，RESCAN时为空
+    std::string path;
+    FileChangeKind kind;
+};
+
+// 基于inotify监视整个目录树
+//
+// 新建的子目录会自动加入监视。同一文件的写入事件在debounce时间内不断出现时不会报告，
+// 直到写入停止debounce时间后才作为一次MODIFIED报告，避免正在复制的大文件被反复处理。
+// 只支持Linux，其他平台start返回false。
+class FolderWatcher
+{
+public:
+    explicit FolderWatcher(const std::string &root,
+                           std::chrono::milliseconds debounce = std::chrono::milliseconds(500));
+    ~FolderWatcher();
+
+public:
+    bool start(std::string &message);
+    // 可以在其他线程中调用，使正在等待的wait_changes返回false
+    void stop();
+    // 阻塞等待下一批变化，停止后返回false
+    bool wait_changes(std::vector<FileChange> &changes);
+    // stop之后返回true，用于中断调用方自己的长时间操作，例如首次扫描
+    bool stopping() const;
+    // 忽略文件名以prefix开头的文件，例如监视目录中自己写出的清单文件
+    void ignore_prefix(const std::string &prefix);
+    // 规范化后的根目录，除根目录"/"外不以'/'结尾
+    const std::string &root() const;
+    // 相对路径对应的完整路径
+    std::string full_path(const std::string &path) const;
+
+private:
+#ifdef __linux__
+    void add_watch_recursive(const std::string &dir, bool report_existing);
+    void remove_watch_recursive(const std::string &dir);
+    void handle_events(const char *buf, size_t len);
+#endif
+    bool ignored(const std::string &name) const;
+
+private:
+    std::string m_root;
+    std::chrono::milliseconds m_debounce;
+    int m_inotify_fd = -1;
+    int m_stop_fd = -1;
+    std::atomic<bool> m_stopping = false;
+    // 监视描述符到相对路径的映射
+    std::unordered_map<int, std::string> m_watches;
+    // 有写入活动的文件及其最后一次活动的时间
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> m_pending;
+    std::set<std::string> m_removed;
+    std::vector<std::string> m_ignored_prefixes;
+    bool m_overflow = false;
+};
+
+#endif // FOLDER_WATCHER_H
@@ -0,0 +1,68 @@
+#ifndef HASH_MANIFEST_H
+#define HASH_MANIFEST_H
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// 清单中一个文件的记录
+struct ManifestEntry
+{
+    uint64_t size = 0;
+    // 文件修改时间，只用于与同一平台上的下一次扫描比较
+    int64_t mtime = 0;
+    // 哈希算法名称和十六进制摘要
+    std::vector<std::pair<std::string, std::string>> digests;
+};
+
+// 目录树的哈希清单
+//
+// 清单保存在根目录下的两个文件中：快照和日志。每次修改只向日志追加一行，
+// 写盘量与变化量成正比；日志行数超过快照的条目数时重写快照（先写临时文件再重命名）并清空日志。
+// 加载时先读快照再重放日志，崩溃时日志末尾写了一半的行会被忽略。
+// 所有方法都是线程安全的。
+class HashManifest
+{
+public:
+    explicit HashManifest(const std::string &root);
+
+public:
+    // 读取磁盘上的清单，清单不存在时为空清单
+    bool load(std::string &message);
+    bool update(const std::string &path, const ManifestEntry &entry, std::string &message);
+    // 同时删除path目录下所有文件的记录
+    bool remove(const std::string &path, std::string &message);
+    // 把内存中的清单写成新的快照并清空日志
+    bool compact(std::string &message);
+    // 大小和修改时间都与清单一致时认为文件没有变化
+    bool up_to_date(const std::string &path, uint64_t size, int64_t mtime) const;
+    std::vector<std::string> paths() const;
+    size_t size() const;
+
+public:
+    // 读取文件的大小和修改时间，文件不存在或不是普通文件时返回false
+    static bool file_stat(const std::string &file_path, uint64_t &size, int64_t &mtime);
+    // 清单自身的文件都以该前缀开头，监视和扫描目录时应跳过
+    static bool is_manifest_file(const std::string &name);
+
+private:
+    bool append_journal(const std::string &line, std::string &message);
+    bool compact_if_needed(std::string &message);
+
+private:
+    mutable std::mutex m_mutex;
+    std::string m_snapshot_path;
+    std::string m_journal_path;
+    std::map<std::string, ManifestEntry> m_entries;
+    size_t m_journal_lines = 0;
+
+public:
+    constexpr static const char *__manifest_name__ = ".ciftl_manifest";
+    constexpr static const char *__journal_suffix__ = ".journal";
+    constexpr static const char *__temp_suffix__ = ".tmp";
+    // 日志至少积累这么多行才会重写快照
+    constexpr static size_t __min_compact_lines__ = 1024;
+};
+
+#endif // HASH_MANIFEST_H
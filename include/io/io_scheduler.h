@@ -0,0 +1,95 @@
+#ifndef IO_SCHEDULER_H
+#define IO_SCHEDULER_H
+#include <map>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+
+// 存储设备的类型
+enum class DeviceKind
+{
+    // 机械硬盘，并发读取会导致磁头来回寻道
+    ROTATIONAL,
+    // SSD/NVMe，可以同时处理多个请求
+    SOLID_STATE,
+    // 网络文件系统、虚拟文件系统等无法判断的设备
+    UNKNOWN,
+};
+
+// 同一设备上的一组文件
+struct DeviceGroup
+{
+    // 整块磁盘的设备号，分区归入所在的磁盘
+    uint64_t device = 0;
+    DeviceKind kind = DeviceKind::UNKNOWN;
+    // 该设备上并发读取的线程数
+    size_t lanes = 1;
+    // 文件在输入中的序号，已按物理位置排好序
+    std::vector<size_t> files;
+};
+
+// 按设备调度多文件读取
+//
+// 输入文件按所在的整块磁盘分组（同一磁盘的各个分区归入一组），每个机械硬盘只有一条顺序读取的通道，SSD有多条，
+// 机械硬盘组内按文件第一个extent在磁盘上的物理偏移排序以减少寻道，无法获取偏移的文件按分区和inode排在其后；
+// 其余设备组内按分区和inode排序。
+// 不同设备之间并行，总吞吐随磁盘数量增加。非Linux平台退化为单通道按输入顺序读取。
+class IoScheduler
+{
+public:
+    IoScheduler(const std::vector<std::string> &file_paths, size_t solid_state_lanes = __default_solid_state_lanes__);
+
+public:
+    // 通道总数，通道编号为[0, lane_count())
+    size_t lane_count() const;
+    const std::vector<DeviceGroup> &groups() const;
+    // 通道所属的设备组
+    const DeviceGroup &group_of(size_t lane) const;
+    // 阻塞执行，task在各通道的线程中被调用（最后一条通道使用调用线程），参数为通道编号、文件序号
+    // 和该通道接下来要读取的文件序号（没有时为__no_file__），调用方可以据此预读
+    void run(const std::function<void(size_t lane, size_t index, size_t next)> &task) const;
+
+public:
+    // 一种设备最多同时读取的线程数
+    static size_t device_lanes(DeviceKind kind, size_t solid_state_lanes);
+
+private:
+    std::vector<DeviceGroup> m_groups;
+
+public:
+    constexpr static size_t __default_solid_state_lanes__ = 4;
+    constexpr static size_t __no_file__ = SIZE_MAX;
+};
+
+// 多个IoScheduler共享的设备通道
+//
+// 每个IoScheduler只调度自己的文件，多个请求同时读取同一块机械硬盘时仍会互相抢占磁头。
+// 读取前在这里排队，同一设备同时读取的线程数不超过该设备的通道数，紧急的等待者先于普通的等待者，
+// 同一优先级内先到先得。
+class DeviceGate
+{
+public:
+    // 阻塞直到设备上有空闲通道，cancelled返回true时放弃排队并返回false
+    bool acquire(uint64_t device, size_t lanes, bool urgent, const std::function<bool()> &cancelled);
+    void release(uint64_t device);
+
+private:
+    struct Device
+    {
+        size_t busy = 0;
+        std::deque<uint64_t> urgent_waiters;
+        std::deque<uint64_t> normal_waiters;
+    };
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::map<uint64_t, Device> m_devices;
+    uint64_t m_next_ticket = 0;
+};
+
+#endif // IO_SCHEDULER_H
@@ -0,0 +1,42 @@
+#ifndef URING_QUEUE_H
+#define URING_QUEUE_H
+#include <memory>
+#include <cstdint>
+#include <functional>
+
+#include "io/file_reader.h"
+
+// 基于io_uring的异步读取队列
+//
+// 同时保持queue_depth个固定大小的读请求，完成顺序不定，按文件偏移重新排序后依次回调。
+// 读缓冲区在RLIMIT_MEMLOCK允许时注册到内核，否则使用普通的READV请求。
+// 一个文件的读请求都提交后，空闲的槽位用来预读同一通道的下一个文件，文件之间队列不会排空。
+// 直接使用系统调用，不依赖liburing。
+class UringQueue
+{
+public:
+    // 内核不支持或io_uring被禁用时返回nullptr，调用方应退回到普通读取
+    static std::unique_ptr<UringQueue> create(size_t queue_depth, size_t block_size);
+    ~UringQueue();
+
+public:
+    // 读取fd中[0, file_size)的内容。next_fd不为-1时，在空闲的槽位中预读next_fd的开头，
+    // 下一次read传入同一个fd时从预读的位置继续。预读的fd在下一次read或discard_prefetch返回前不能关闭
+    FileReadStatus read(int fd, uint64_t file_size, const FileBlockHandler &handler, RateLimiter *rate_limiter,
+                        const std::function<bool()> &cancelled, int next_fd = -1, uint64_t next_size = 0);
+    // 放弃预读并等待其在途请求完成
+    void discard_prefetch();
+    // 等待完成事件失败后队列中可能仍有在途请求，不能再读取其他文件，调用方应丢弃队列
+    bool broken() const;
+    // 读缓冲区是否注册到了内核
+    bool registered() const;
+
+private:
+    UringQueue() = default;
+
+private:
+    struct Ring;
+    std::unique_ptr<Ring> m_ring;
+};
+
+#endif // URING_QUEUE_H
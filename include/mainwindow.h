@@ -26,8 +26,16 @@ private:
     Ui::MainWindow *ui;
 
 protected:
-    CrypterForm *m_crypter_form;
-    HashForm *m_hash_form;
+    // 工具页在第一次切换到时才创建
+    CrypterForm *m_crypter_form = nullptr;
+    HashForm *m_hash_form = nullptr;
+    // mainwindow.ui中的默认样式表
+    QString m_default_style_sheet;
+
+protected:
+    CrypterForm *crypter_form();
+    HashForm *hash_form();
+    void load_theme_menu();
 
 public:
     void show();
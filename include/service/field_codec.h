@@ -0,0 +1,16 @@
+#ifndef FIELD_CODEC_H
+#define FIELD_CODEC_H
+#include <string>
+#include <vector>
+#include <string_view>
+
+// 以制表符分隔的一行字段，字段中的反斜杠、制表符和换行符被转义，用于清单和守护进程协议
+class FieldCodec
+{
+public:
+    static std::string join(const std::vector<std::string> &fields);
+    // 含有非法的转义序列时返回false
+    static bool split(std::string_view line, std::vector<std::string> &fields);
+};
+
+#endif // FIELD_CODEC_H
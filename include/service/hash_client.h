@@ -0,0 +1,25 @@
+#ifndef HASH_CLIENT_H
+#define HASH_CLIENT_H
+#include <string>
+#include <functional>
+
+#include "service/hash_engine.h"
+#include "service/unix_socket.h"
+
+// 校验守护进程的客户端，一个连接只发送一个请求
+class HashClient
+{
+public:
+    // 守护进程没有运行（套接字文件不存在或拒绝连接）或监听套接字的进程不属于当前用户时返回false
+    bool connect(const std::string &socket_path, std::string &message);
+    // 发送请求并在当前线程中接收结果，调用callback的on_progress和on_result（不调用on_end）。
+    // cancelled返回true时断开连接，守护进程随即取消请求。连接中断或守护进程报错时返回false。
+    // 传给on_result的结果序号保证小于request.file_paths.size()
+    bool hash(const HashRequest &request, const HashCallback &callback, const std::function<bool()> &cancelled,
+              std::string &message);
+
+private:
+    UnixSocket m_socket;
+};
+
+#endif // HASH_CLIENT_H
@@ -0,0 +1,28 @@
+#ifndef HASH_COMMAND_H
+#define HASH_COMMAND_H
+#include <string>
+#include <vector>
+
+// 命令行模式，不创建窗口
+//
+//     ciftl-gui --daemon [--socket 路径]
+//         运行校验守护进程，收到SIGINT或SIGTERM后退出
+//     ciftl-gui --hash [--algorithm MD5,Sha1,Sha256,Sha512] [--socket 路径] [--local] 文件...
+//         校验文件，守护进程在运行时交给它计算，否则（或指定--local时）在本进程中计算。
+//         每个摘要输出一行"算法 (文件) = 摘要"
+class HashCommand
+{
+public:
+    static bool is_command(const char *arg);
+    static int run(int argc, char *argv[]);
+
+private:
+    static int run_daemon(const std::string &socket_path);
+    static int run_hash(const std::string &socket_path, bool local, const std::vector<std::string> &hasher_names,
+                        const std::vector<std::string> &file_paths);
+
+public:
+    constexpr static const char *__default_algorithm__ = "Sha256";
+};
+
+#endif // HASH_COMMAND_H
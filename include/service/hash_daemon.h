@@ -0,0 +1,57 @@
+#ifndef HASH_DAEMON_H
+#define HASH_DAEMON_H
+#include <map>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "service/hash_engine.h"
+#include "service/unix_socket.h"
+
+// 本机的校验守护进程
+//
+// 在Unix域套接字上接受请求，所有客户端共用一个HashEngine，因此共享工作线程、磁盘调度和摘要缓存，
+// 多个客户端同时校验同一文件时只读取一次。每个连接由一个线程负责收发，客户端断开时取消其请求。
+// 只接受与守护进程同一用户的连接，避免其他用户借此得到自己无权读取的文件的摘要。
+class HashDaemon
+{
+public:
+    explicit HashDaemon(const std::string &socket_path = default_socket_path(),
+                        size_t worker_count = HashEngine::__default_worker_count__);
+    ~HashDaemon();
+
+public:
+    bool start(std::string &message);
+    // 阻塞处理连接，直到stop
+    void run();
+    // 可以在其他线程或信号处理线程中调用
+    void stop();
+
+public:
+    // $XDG_RUNTIME_DIR/ciftl-gui.sock，没有该环境变量时为/tmp/ciftl-gui-<uid>/ciftl-gui.sock
+    static std::string default_socket_path();
+
+private:
+    // 没有$XDG_RUNTIME_DIR时套接字所在的目录，只有当前用户可以访问
+    static std::string fallback_socket_dir();
+    // 建立或检查套接字目录：必须是当前用户所有的真实目录，且组和其他用户没有任何权限
+    static bool prepare_socket_dir(const std::string &dir, std::string &message);
+
+private:
+    void serve(UnixSocket &client);
+
+private:
+    std::string m_socket_path;
+    HashEngine m_engine;
+    UnixSocket m_listener;
+    int m_stop_fd = -1;
+    std::mutex m_mutex;
+    // 连接线程及其套接字，结束的线程在下一次accept时回收
+    std::map<size_t, std::pair<std::thread, std::shared_ptr<UnixSocket>>> m_clients;
+    std::vector<size_t> m_finished;
+    size_t m_next_client = 0;
+};
+
+#endif // HASH_DAEMON_H
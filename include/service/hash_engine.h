@@ -0,0 +1,130 @@
+#ifndef HASH_ENGINE_H
+#define HASH_ENGINE_H
+#include <set>
+#include <map>
+#include <list>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <condition_variable>
+
+#include <ciftl/hash/hash.h>
+
+#include "etc/job_queue.h"
+#include "io/file_reader.h"
+#include "io/io_scheduler.h"
+
+// 一次校验请求
+struct HashRequest
+{
+    std::vector<std::string> file_paths;
+    std::vector<std::string> hasher_names;
+    FileReadMode mode = FileReadMode::BUFFERED;
+    // 每秒读取的字节数，0表示不限速。限速作用于整个引擎：运行期间所有请求的读取合计不超过这个速度
+    uint64_t rate_limit = 0;
+    JobPriority priority = JobPriority::NORMAL;
+};
+
+// 单个文件的校验结果
+struct HashResult
+{
+    // 文件在请求中的序号
+    size_t index = 0;
+    FileReadStatus status = FileReadStatus::OK;
+    uint64_t size = 0;
+    // 没有为这个请求读取文件，摘要来自缓存或同时进行的其他请求
+    bool shared = false;
+    std::vector<std::pair<std::string, std::string>> digests;
+    // 读取方式的降级说明，见FileReader::note
+    std::string note;
+};
+
+// 请求的回调，在工作线程中调用，同一请求的回调不会同时进入
+struct HashCallback
+{
+    // 当前文件的读取进度，百分比
+    std::function<void(size_t percent)> on_progress;
+    std::function<void(const HashResult &result)> on_result;
+    // 所有文件处理完或取消后调用一次
+    std::function<void()> on_end;
+};
+
+using HasherVec = std::vector<std::pair<std::string, std::shared_ptr<ciftl::IHasher>>>;
+
+// 带摘要缓存的校验引擎
+//
+// 持有工作线程和最近计算过的摘要（按路径、大小和修改时间识别）。多个请求同时需要同一个文件时只读取一次：
+// 后到的请求等待正在进行的读取，算法不同时只补算缺少的部分。守护进程和命令行的本地模式共用此类。
+// 所有请求在同一组设备通道上排队，每读完一块重新排队，多个客户端同时读取一块机械硬盘时轮流整块读取而不是互相抢占磁头；
+// 所有请求共用一个限速器，速度取运行中的请求要求的最小值。
+class HashEngine
+{
+public:
+    explicit HashEngine(size_t worker_count = __default_worker_count__,
+                        size_t cache_capacity = __default_cache_capacity__);
+
+public:
+    std::shared_ptr<JobControl> submit(const HashRequest &request, const HashCallback &callback);
+    void cancel_all();
+
+public:
+    static HasherVec generate_hasher_vec(const std::vector<std::string> &hasher_names);
+    // 按块读取文件并计算摘要，每读取一块调用一次on_block，参数为已读取的字节数，返回false时停止
+    static FileReadStatus digest_file(FileReader &reader, const std::vector<std::string> &hasher_names,
+                                      const std::string &file_path, const std::function<bool(size_t)> &on_block,
+                                      std::vector<std::pair<std::string, std::string>> &digests);
+
+private:
+    struct CacheEntry
+    {
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        std::map<std::string, std::string> digests;
+        std::list<std::string>::iterator lru;
+    };
+
+    // 正在进行的读取
+    struct InFlight
+    {
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        std::vector<std::string> hasher_names;
+        JobPriority priority = JobPriority::NORMAL;
+        bool done = false;
+    };
+
+    void hash_one(FileReader &reader, JobControl &control, const DeviceGroup &group,
+                  const std::vector<std::string> &hasher_names, const std::string &file_path,
+                  const std::function<void(size_t)> &on_progress, HashResult &result);
+    // 运行中的请求的限速变化后调用，需持有m_mutex
+    void update_rate_limit();
+    // 以下函数需持有m_mutex
+    void cached_digests(const std::string &key, uint64_t size, int64_t mtime,
+                        std::map<std::string, std::string> &digests);
+    void store_digests(const std::string &key, uint64_t size, int64_t mtime,
+                       const std::vector<std::pair<std::string, std::string>> &digests);
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::unordered_map<std::string, CacheEntry> m_cache;
+    // 最近使用的在前
+    std::list<std::string> m_lru;
+    size_t m_cache_capacity;
+    std::unordered_map<std::string, std::vector<std::shared_ptr<InFlight>>> m_in_flight;
+    // 运行中的请求要求的限速，不含不限速的请求
+    std::multiset<uint64_t> m_rate_limits;
+    std::shared_ptr<RateLimiter> m_rate_limiter;
+    DeviceGate m_device_gate;
+    // 最后声明因而最先析构，等待所有任务结束后缓存才被释放
+    JobQueue m_job_queue;
+
+public:
+    constexpr static size_t __default_worker_count__ = 2;
+    constexpr static size_t __default_cache_capacity__ = 65536;
+};
+
+#endif // HASH_ENGINE_H
@@ -0,0 +1,40 @@
+#ifndef HASH_PROTOCOL_H
+#define HASH_PROTOCOL_H
+#include <string>
+
+#include "service/hash_engine.h"
+
+// 守护进程回复的类型
+enum class HashReplyKind
+{
+    PROGRESS,
+    RESULT,
+    FAILED,
+    END,
+};
+
+// 守护进程与客户端之间的协议
+//
+// 每条消息一行，字段以制表符分隔并转义（见FieldCodec）。客户端发送一行请求：
+//     hash 优先级 读取方式 限速 算法1,算法2 路径1 路径2 ...
+// 守护进程依次回复任意行progress（百分比）和result（序号 状态 大小 是否共享 降级说明 算法=摘要...），
+// 最后以end结束，出错时以error（消息）结束。客户端断开连接即取消请求。
+class HashProtocol
+{
+public:
+    static std::string encode_request(const HashRequest &request);
+    static bool decode_request(const std::string &line, HashRequest &request);
+    static std::string encode_progress(size_t percent);
+    static std::string encode_result(const HashResult &result);
+    static std::string encode_error(const std::string &message);
+    static std::string encode_end();
+    // 按回复的类型填写percent、result或message
+    static bool decode_reply(const std::string &line, HashReplyKind &kind, size_t &percent, HashResult &result,
+                             std::string &message);
+
+public:
+    // 请求行的最大长度，防止异常的客户端占用过多内存
+    constexpr static size_t __max_line_size__ = 64 * 1024 * 1024;
+};
+
+#endif // HASH_PROTOCOL_H
@@ -0,0 +1,36 @@
+#ifndef UNIX_SOCKET_H
+#define UNIX_SOCKET_H
+#include <string>
+
+// 按行收发的Unix域套接字，只支持Linux，其他平台所有操作都失败
+class UnixSocket
+{
+public:
+    UnixSocket() = default;
+    explicit UnixSocket(int fd);
+    ~UnixSocket();
+    UnixSocket(const UnixSocket &) = delete;
+    UnixSocket &operator=(const UnixSocket &) = delete;
+
+public:
+    bool connect(const std::string &path, std::string &message);
+    // 监听path，已有进程在监听时失败，残留的套接字文件会被删除。套接字文件只允许当前用户访问
+    bool listen(const std::string &path, std::string &message);
+    // 阻塞等待新连接或wake_fd可读，后者返回-1
+    int accept(int wake_fd);
+    bool send_line(const std::string &line);
+    // 读取一行（不含换行符），timeout_ms内没有完整的一行时返回false且timed_out为true，
+    // 连接关闭、出错或行过长时返回false且timed_out为false
+    bool read_line(std::string &line, int timeout_ms, bool &timed_out, size_t max_size);
+    // 对端进程的用户是否与当前进程相同
+    bool same_user() const;
+    // 使其他线程中阻塞的读写立即返回
+    void shutdown();
+    int fd() const;
+
+private:
+    int m_fd = -1;
+    std::string m_buffer;
+};
+
+#endif // UNIX_SOCKET_H
@@ -0,0 +1,134 @@
+#include <algorithm>
+
+#include <zstd.h>
+#include <zdict.h>
+
+#include "cryption/compressor.h"
+
+Compressor::Compressor(int level, const std::string &dictionary)
+    : m_level(std::clamp(level, __min_level__, __max_level__))
+{
+    m_cctx = ZSTD_createCCtx();
+    m_dctx = ZSTD_createDCtx();
+    if (!dictionary.empty())
+    {
+        m_cdict = ZSTD_createCDict(dictionary.data(), dictionary.size(), m_level);
+        m_ddict = ZSTD_createDDict(dictionary.data(), dictionary.size());
+        m_dictionary_id = ZSTD_getDictID_fromDict(dictionary.data(), dictionary.size());
+    }
+}
+
+Compressor::~Compressor()
+{
+    ZSTD_freeCDict(m_cdict);
+    ZSTD_freeDDict(m_ddict);
+    ZSTD_freeCCtx(m_cctx);
+    ZSTD_freeDCtx(m_dctx);
+}
+
+bool Compressor::compress(const uint8_t *data, size_t len, std::string &out)
+{
+    out.clear();
+    if (!m_cctx || !len)
+    {
+        return false;
+    }
+    // 输出缓冲区只比原文小一个字节，放不下说明压缩没有收益
+    out.resize(len - 1);
+    size_t ret;
+    if (m_cdict)
+    {
+        ret = ZSTD_compress_usingCDict(m_cctx, out.data(), out.size(), data, len, m_cdict);
+    }
+    else
+    {
+        ret = ZSTD_compressCCtx(m_cctx, out.data(), out.size(), data, len, m_level);
+    }
+    if (ZSTD_isError(ret))
+    {
+        out.clear();
+        return false;
+    }
+    out.resize(ret);
+    return true;
+}
+
+bool Compressor::decompress(const uint8_t *data, size_t len, size_t max_size, std::string &out, std::string &message)
+{
+    out.clear();
+    if (!m_dctx)
+    {
+        message = "无法创建解压上下文";
+        return false;
+    }
+    unsigned long long size = ZSTD_getFrameContentSize(data, len);
+    if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN || size > max_size)
+    {
+        message = "压缩数据已损坏";
+        return false;
+    }
+    // 帧头中记录了压缩时使用的字典
+    unsigned dictionary_id = ZSTD_getDictID_fromFrame(data, len);
+    if (dictionary_id && dictionary_id != m_dictionary_id)
+    {
+        message = "需要ID为" + std::to_string(dictionary_id) + "的压缩字典";
+        return false;
+    }
+    out.resize((size_t)size);
+    size_t ret = dictionary_id ? ZSTD_decompress_usingDDict(m_dctx, out.data(), out.size(), data, len, m_ddict)
+                               : ZSTD_decompressDCtx(m_dctx, out.data(), out.size(), data, len);
+    if (ZSTD_isError(ret) || ret != size)
+    {
+        out.clear();
+        message = "解压失败";
+        return false;
+    }
+    return true;
+}
+
+uint32_t Compressor::dictionary_id() const
+{
+    return m_dictionary_id;
+}
+
+std::string Compressor::train_dictionary(const std::vector<std::string> &samples, size_t capacity, std::string &message)
+{
+    std::string buffer;
+    std::vector<size_t> sizes;
+    for (const auto &sample : samples)
+    {
+        if (!sample.empty())
+        {
+            buffer += sample;
+            sizes.push_back(sample.size());
+        }
+    }
+    std::string dictionary(capacity, '\0');
+    size_t ret = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(), buffer.data(), sizes.data(),
+                                       (unsigned)sizes.size());
+    if (ZDICT_isError(ret))
+    {
+        // 样本太少或太短时训练会失败
+        message = std::string("训练字典失败：") + ZDICT_getErrorName(ret);
+        return "";
+    }
+    dictionary.resize(ret);
+    return dictionary;
+}
+
+bool Compressor::check_dictionary(const std::string &dictionary, std::string &message)
+{
+    if (!ZSTD_getDictID_fromDict(dictionary.data(), dictionary.size()))
+    {
+        message = "不是zstd格式的字典（没有字典ID）";
+        return false;
+    }
+    ZSTD_DDict *ddict = ZSTD_createDDict(dictionary.data(), dictionary.size());
+    if (!ddict)
+    {
+        message = "字典已损坏";
+        return false;
+    }
+    ZSTD_freeDDict(ddict);
+    return true;
+}
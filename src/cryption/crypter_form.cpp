@@ -1,8 +1,10 @@
 #include <map>
+#include <fstream>
 
 #include <QMessageBox>
 #include <QClipboard>
 #include <QProcess>
+#include <QFileDialog>
 
 #include <fmt/core.h>
 
@@ -11,7 +13,11 @@
 #include "mainwindow.h"
 
 #include "cryption/crypter_form.h"
+#include "cryption/compressor.h"
+#include "cryption/file_crypter.h"
+#include "cryption/string_pipeline.h"
 #include "etc/line_importer.h"
+#include "etc/local_path.h"
 
 #include "ui_crypter_form.h"
 
@@ -30,7 +36,7 @@ const std::unordered_map<std::string, CipherAlgorithm> CrypterForm::__str_to_cip
 CrypterForm::CrypterForm(QWidget *parent) : QWidget(parent),
                                             ui(new Ui::CrypterForm),
                                             m_parent_widget(dynamic_cast<MainWindow *>(parent)),
-                                            m_line_importer(new LineImporter(parent))
+                                            m_line_importer(nullptr)
 {
     ui->setupUi(this);
     connect(ui->pushButtonEncrypt, &QPushButton::clicked,
@@ -43,15 +49,29 @@ CrypterForm::CrypterForm(QWidget *parent) : QWidget(parent),
             this, &CrypterForm::add_text);
     connect(ui->pushButtonClear, &QPushButton::clicked,
             this, &CrypterForm::clear_table);
-    connect(m_line_importer, SIGNAL(table_update(std::vector<CrypterTableData>)),
-            this, SLOT(update_table(std::vector<CrypterTableData>)));
     connect(ui->pushButtonCopy, &QPushButton::clicked,
             this, &CrypterForm::copy_result);
+    connect(ui->pushButtonEncryptFile, &QPushButton::clicked,
+            this, &CrypterForm::encrypt_file);
+    connect(ui->pushButtonDecryptFile, &QPushButton::clicked,
+            this, &CrypterForm::decrypt_file);
+    connect(ui->pushButtonLoadDictionary, &QPushButton::clicked,
+            this, &CrypterForm::load_dictionary);
+    connect(ui->pushButtonTrainDictionary, &QPushButton::clicked,
+            this, &CrypterForm::train_dictionary);
+    connect(this, &CrypterForm::file_operation_start,
+            this, &CrypterForm::start_file_operation);
+    connect(this, &CrypterForm::file_operation_end,
+            this, &CrypterForm::end_file_operation);
+    connect(this, &CrypterForm::file_progress_update,
+            this, &CrypterForm::update_file_progress);
     // 加载下拉框
     for(const auto& iter : __supported_cipher_algorithm__)
     {
         ui->comboBoxCipherType->addItem(QString::fromStdString(iter.first));
     }
+    ui->spinBoxCompressLevel->setRange(Compressor::__min_level__, Compressor::__max_level__);
+    ui->spinBoxCompressLevel->setValue(Compressor::__default_level__);
     // 初始化表格
     CrypterTableDataModel *model = new CrypterTableDataModel({}, this);
     ui->tableView->setModel(model);
@@ -62,6 +82,10 @@ CrypterForm::CrypterForm(QWidget *parent) : QWidget(parent),
 CrypterForm::~CrypterForm()
 
 {
+    if (m_file_thread)
+    {
+        m_file_thread->join();
+    }
     delete ui;
 }
 
@@ -133,6 +157,13 @@ void CrypterForm::clear_table()
 
 void CrypterForm::add_text()
 {
+    // 导入对话框在第一次使用时才创建
+    if (!m_line_importer)
+    {
+        m_line_importer = new LineImporter(window());
+        connect(m_line_importer, SIGNAL(table_update(std::vector<CrypterTableData>)),
+                this, SLOT(update_table(std::vector<CrypterTableData>)));
+    }
     m_line_importer->show();
 }
 
@@ -179,6 +210,15 @@ inline std::shared_ptr<IStringCrypter> string_crypter_selection(const std::strin
     }
 }
 
+StringCompressOption CrypterForm::compress_option()
+{
+    StringCompressOption option;
+    option.enabled = ui->checkBoxCompress->isChecked();
+    option.level = ui->spinBoxCompressLevel->value();
+    option.dictionary = m_dictionary;
+    return option;
+}
+
 void CrypterForm::encrypt()
 {
     QString password = ui->lineEditPassword->text().trimmed();
@@ -197,24 +237,11 @@ void CrypterForm::encrypt()
         QMessageBox::critical(this, "错误", "待加密内容不能为空");
         return;
     }
-    std::shared_ptr<IStringCrypter> string_crypter = string_crypter_selection(ui->comboBoxCipherType->currentText().toStdString());
-    for (auto &item : *res_data->get_raw_data())
-    {
-        std::string plain_text = item.src_text;
-        std::string password = ui->lineEditPassword->text().toStdString();
-        auto res = string_crypter->encrypt(plain_text, password);
-        if (res.is_ok())
-        {
-            item.res_text = res.ok().value();
-            item.res_mes = "成功";
-        }
-        else
-        {
-            item.res_text.clear();
-            item.res_mes =
-                fmt::format("{}: {}", res.error().value().error_code(), res.error().value().error_message());
-        }
-    }
+    std::string algo_name = ui->comboBoxCipherType->currentText().toStdString();
+    StringPipeline pipeline([algo_name]()
+                            { return string_crypter_selection(algo_name); },
+                            ui->lineEditPassword->text().toStdString(), compress_option());
+    pipeline.encrypt(*res_data->get_raw_data());
     refresh_table();
 }
 
@@ -236,23 +263,163 @@ void CrypterForm::decrypt()
         QMessageBox::critical(this, "错误", "待解密内容不能为空");
         return;
     }
-    std::shared_ptr<IStringCrypter> string_crypter = string_crypter_selection(ui->comboBoxCipherType->currentText().toStdString());
-    for (auto &item : *res_data->get_raw_data())
+    // 是否需要解压由密文的前缀决定，与压缩选项无关
+    std::string algo_name = ui->comboBoxCipherType->currentText().toStdString();
+    StringPipeline pipeline([algo_name]()
+                            { return string_crypter_selection(algo_name); },
+                            ui->lineEditPassword->text().toStdString(), compress_option());
+    pipeline.decrypt(*res_data->get_raw_data());
+    refresh_table();
+}
+
+void CrypterForm::load_dictionary()
+{
+    QString q_file_path = QFileDialog::getOpenFileName(this, "选择压缩字典", QDir::homePath(), "zstd字典 (*.dict);;所有文件 (*.*)");
+    if (q_file_path.isEmpty())
     {
-        std::string cipher_text = item.src_text;
-        std::string password = ui->lineEditPassword->text().toStdString();
-        auto res = string_crypter->decrypt(cipher_text, password);
-        if (res.is_ok())
-        {
-            item.res_text = res.ok().value();
-            item.res_mes = "成功";
-        }
-        else
-        {
-            item.res_text.clear();
-            item.res_mes =
-                fmt::format("{}: {}", res.error().value().error_code(), res.error().value().error_message());
-        }
+        return;
     }
-    refresh_table();
+    std::ifstream ifs(to_local_path(q_file_path), std::ios::in | std::ios::binary);
+    if (!ifs)
+    {
+        QMessageBox::critical(this, "错误", "无法打开文件：" + q_file_path);
+        return;
+    }
+    std::string dictionary((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    std::string message;
+    if (!Compressor::check_dictionary(dictionary, message))
+    {
+        QMessageBox::critical(this, "错误", QString::fromStdString(message));
+        return;
+    }
+    m_dictionary = std::move(dictionary);
+    update_file_progress(QString::fromStdString(
+        fmt::format("已加载压缩字典，ID: {}", Compressor(Compressor::__default_level__, m_dictionary).dictionary_id())));
+}
+
+void CrypterForm::train_dictionary()
+{
+    CrypterTableDataModel *res_data = dynamic_cast<CrypterTableDataModel *>(ui->tableView->model());
+    if (!res_data)
+    {
+        exit(-1);
+    }
+    // 以表格中的原始数据为样本
+    std::vector<std::string> samples;
+    for (const auto &item : *res_data->get_raw_data())
+    {
+        samples.push_back(item.src_text);
+    }
+    std::string message;
+    std::string dictionary = Compressor::train_dictionary(samples, Compressor::__default_dictionary_capacity__, message);
+    if (dictionary.empty())
+    {
+        QMessageBox::critical(this, "错误", QString::fromStdString(message));
+        return;
+    }
+    // 解密时需要同一个字典，必须先保存下来
+    QString q_file_path = QFileDialog::getSaveFileName(this, "保存压缩字典", QDir::homePath(), "zstd字典 (*.dict)");
+    if (q_file_path.isEmpty())
+    {
+        return;
+    }
+    std::ofstream ofs(to_local_path(q_file_path), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!ofs.write(dictionary.data(), dictionary.size()))
+    {
+        QMessageBox::critical(this, "错误", "无法写入文件：" + q_file_path);
+        return;
+    }
+    m_dictionary = std::move(dictionary);
+    update_file_progress(QString::fromStdString(
+        fmt::format("已训练并加载压缩字典，ID: {}", Compressor(Compressor::__default_level__, m_dictionary).dictionary_id())));
+}
+
+void CrypterForm::encrypt_file()
+{
+    do_file_cryption(CryptionMode::ENCRYPTION);
+}
+
+void CrypterForm::decrypt_file()
+{
+    do_file_cryption(CryptionMode::DECRYPTION);
+}
+
+void CrypterForm::start_file_operation()
+{
+    this->setEnabled(false);
+}
+
+void CrypterForm::end_file_operation(QString message)
+{
+    this->setEnabled(true);
+    if (m_file_thread)
+    {
+        m_file_thread->join();
+        m_file_thread = nullptr;
+    }
+    update_file_progress(message);
+}
+
+void CrypterForm::update_file_progress(QString message)
+{
+    if (m_parent_widget)
+    {
+        m_parent_widget->set_status_message(message);
+    }
+}
+
+void CrypterForm::do_file_cryption(CryptionMode mode)
+{
+    if (m_file_thread)
+    {
+        return;
+    }
+    QString password = ui->lineEditPassword->text().trimmed();
+    if (password.isEmpty())
+    {
+        QMessageBox::critical(this, "错误", "密码不能为空");
+        return;
+    }
+    bool encryption = mode == CryptionMode::ENCRYPTION;
+    // 选取源文件和目标文件
+    QString q_src_path = encryption
+                             ? QFileDialog::getOpenFileName(this, "选择待加密文件", QDir::homePath(), "所有文件 (*.*)")
+                             : QFileDialog::getOpenFileName(this, "选择待解密文件", QDir::homePath(), "加密文件 (*.ciftl);;所有文件 (*.*)");
+    if (q_src_path.isEmpty())
+    {
+        return;
+    }
+    QString q_default_dst_path = encryption
+                                     ? q_src_path + ".ciftl"
+                                     : (q_src_path.endsWith(".ciftl") ? q_src_path.chopped(6) : q_src_path + ".dec");
+    QString q_dst_path = QFileDialog::getSaveFileName(this, "保存文件", q_default_dst_path, "所有文件 (*.*)");
+    if (q_dst_path.isEmpty())
+    {
+        return;
+    }
+    if (q_dst_path == q_src_path)
+    {
+        QMessageBox::critical(this, "错误", "目标文件不能与源文件相同");
+        return;
+    }
+    FileCrypterOption option;
+    option.algorithm = __str_to_cipher_algorithm__.at(ui->comboBoxCipherType->currentText().toStdString());
+    option.compress = ui->checkBoxCompress->isChecked();
+    option.compress_level = ui->spinBoxCompressLevel->value();
+    auto file_crypter = std::make_shared<FileCrypter>(ui->lineEditPassword->text().toStdString(), option);
+    auto src_path = to_local_path(q_src_path);
+    auto dst_path = to_local_path(q_dst_path);
+    emit file_operation_start();
+    m_file_thread = std::make_unique<std::thread>([this, file_crypter, src_path, dst_path, encryption]()
+                                                  {
+        const char *action = encryption ? "加密" : "解密";
+        auto progress = [this, action](uint64_t done, uint64_t total)
+        {
+            emit file_progress_update(QString::fromStdString(
+                fmt::format("正在{}文件: {:.1f}%", action, total ? 100.0 * done / total : 100.0)));
+        };
+        auto res = encryption ? file_crypter->encrypt_file(src_path, dst_path, progress)
+                              : file_crypter->decrypt_file(src_path, dst_path, progress);
+        emit file_operation_end(QString::fromStdString(
+            res.ok ? fmt::format("文件{}成功", action) : fmt::format("文件{}失败: {}", action, res.message))); });
 }
@@ -0,0 +1,806 @@
+#include <mutex>
+#include <thread>
+#include <fstream>
+#include <cstring>
+#include <iterator>
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <condition_variable>
+
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/crypto.h>
+
+#include "cryption/compressor.h"
+#include "cryption/file_crypter.h"
+#include "cryption/keystream.h"
+
+namespace
+{
+    constexpr char MAGIC[8] = {'C', 'I', 'F', 'T', 'L', 'E', 'N', 'C'};
+    constexpr size_t SALT_LENGTH = 16;
+    constexpr size_t NONCE_LENGTH = 16;
+    constexpr size_t MAC_LENGTH = 32;
+    constexpr size_t HEADER_BODY_LENGTH = 8 + 1 + 1 + 2 + 4 + 4 + SALT_LENGTH + NONCE_LENGTH + 8;
+    constexpr size_t HEADER_LENGTH = HEADER_BODY_LENGTH + MAC_LENGTH;
+    // 压缩容器中每块前的长度字段
+    constexpr size_t STORED_LENGTH = 4;
+    // 压缩容器末尾索引中每块的偏移
+    constexpr size_t INDEX_ENTRY_LENGTH = 8;
+    constexpr uint16_t FLAG_COMPRESSED = 1;
+    constexpr uint32_t STORED_COMPRESSED = 0x80000000u;
+
+    template <typename T>
+    void put_le(uint8_t *p, T val)
+    {
+        for (size_t i = 0; i < sizeof(T); i++)
+        {
+            p[i] = (uint8_t)(val >> (8 * i));
+        }
+    }
+
+    template <typename T>
+    T get_le(const uint8_t *p)
+    {
+        T val = 0;
+        for (size_t i = 0; i < sizeof(T); i++)
+        {
+            val |= (T)p[i] << (8 * i);
+        }
+        return val;
+    }
+
+    // 文件头
+    struct FileHeader
+    {
+        uint8_t version;
+        uint16_t flags;
+        CipherAlgorithm algorithm;
+        uint32_t chunk_size;
+        uint32_t kdf_iterations;
+        uint8_t salt[SALT_LENGTH];
+        uint8_t nonce[NONCE_LENGTH];
+        uint64_t plain_size;
+        uint8_t mac[MAC_LENGTH];
+
+        uint64_t chunk_count() const
+        {
+            return (plain_size + chunk_size - 1) / chunk_size;
+        }
+
+        // 第index块的明文长度
+        size_t chunk_length(uint64_t index) const
+        {
+            return (size_t)std::min<uint64_t>(chunk_size, plain_size - index * chunk_size);
+        }
+
+        bool compressed() const
+        {
+            return flags & FLAG_COMPRESSED;
+        }
+
+        // 第index块在容器文件中的偏移，只适用于未压缩的容器
+        uint64_t chunk_offset(uint64_t index) const
+        {
+            return HEADER_LENGTH + index * (chunk_size + MAC_LENGTH);
+        }
+
+        uint64_t container_size() const
+        {
+            return HEADER_LENGTH + plain_size + chunk_count() * MAC_LENGTH;
+        }
+
+        // 压缩容器末尾块偏移索引的长度
+        uint64_t index_length() const
+        {
+            return compressed() ? chunk_count() * INDEX_ENTRY_LENGTH : 0;
+        }
+
+        void serialize_body(uint8_t *p) const
+        {
+            std::memcpy(p, MAGIC, sizeof(MAGIC));
+            p += sizeof(MAGIC);
+            *p++ = version;
+            *p++ = (uint8_t)algorithm;
+            put_le<uint16_t>(p, flags);
+            p += 2;
+            put_le<uint32_t>(p, chunk_size);
+            p += 4;
+            put_le<uint32_t>(p, kdf_iterations);
+            p += 4;
+            std::memcpy(p, salt, SALT_LENGTH);
+            p += SALT_LENGTH;
+            std::memcpy(p, nonce, NONCE_LENGTH);
+            p += NONCE_LENGTH;
+            put_le<uint64_t>(p, plain_size);
+        }
+
+        // 解析文件头，不校验MAC
+        bool parse(const uint8_t *p)
+        {
+            if (std::memcmp(p, MAGIC, sizeof(MAGIC)) != 0)
+            {
+                return false;
+            }
+            p += sizeof(MAGIC);
+            version = *p++;
+            algorithm = (CipherAlgorithm)*p++;
+            flags = get_le<uint16_t>(p);
+            p += 2;
+            // 版本1只有未压缩的格式，版本2必须是压缩格式
+            bool plain_format = version == FileCrypter::__container_version__ && flags == 0;
+            bool compressed_format = version == FileCrypter::__compressed_container_version__ && flags == FLAG_COMPRESSED;
+            if (!plain_format && !compressed_format)
+            {
+                return false;
+            }
+            chunk_size = get_le<uint32_t>(p);
+            p += 4;
+            kdf_iterations = get_le<uint32_t>(p);
+            p += 4;
+            std::memcpy(salt, p, SALT_LENGTH);
+            p += SALT_LENGTH;
+            std::memcpy(nonce, p, NONCE_LENGTH);
+            p += NONCE_LENGTH;
+            plain_size = get_le<uint64_t>(p);
+            p += 8;
+            std::memcpy(mac, p, MAC_LENGTH);
+            return KeystreamCipher::is_supported(algorithm) &&
+                   chunk_size >= FileCrypter::__min_chunk_size__ &&
+                   chunk_size <= FileCrypter::__max_chunk_size__ &&
+                   kdf_iterations > 0 &&
+                   kdf_iterations <= FileCrypter::__max_kdf_iterations__;
+        }
+    };
+
+    // 由密码派生出的加密密钥和认证密钥
+    struct DerivedKey
+    {
+        uint8_t cipher_key[32];
+        uint8_t mac_key[32];
+    };
+
+    bool derive_key(const std::string &password, const FileHeader &header, DerivedKey &key)
+    {
+        if (!KeystreamCipher::is_supported(header.algorithm))
+        {
+            return false;
+        }
+        uint8_t buf[64];
+        if (!PKCS5_PBKDF2_HMAC(password.data(), (int)password.size(),
+                               header.salt, SALT_LENGTH, (int)header.kdf_iterations,
+                               EVP_sha256(), sizeof(buf), buf))
+        {
+            return false;
+        }
+        std::memcpy(key.cipher_key, buf, 32);
+        std::memcpy(key.mac_key, buf + 32, 32);
+        OPENSSL_cleanse(buf, sizeof(buf));
+        return true;
+    }
+
+    // HMAC-SHA256，输入为若干段连续的内存
+    bool hmac_sha256(const uint8_t *key, std::initializer_list<std::pair<const uint8_t *, size_t>> parts,
+                     uint8_t *out)
+    {
+        EVP_PKEY *pkey = EVP_PKEY_new_raw_private_key(EVP_PKEY_HMAC, nullptr, key, 32);
+        EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+        bool ok = pkey && ctx && EVP_DigestSignInit(ctx, nullptr, EVP_sha256(), nullptr, pkey) == 1;
+        for (auto iter = parts.begin(); ok && iter != parts.end(); ++iter)
+        {
+            ok = EVP_DigestSignUpdate(ctx, iter->first, iter->second) == 1;
+        }
+        size_t out_len = MAC_LENGTH;
+        ok = ok && EVP_DigestSignFinal(ctx, out, &out_len) == 1 && out_len == MAC_LENGTH;
+        EVP_MD_CTX_free(ctx);
+        EVP_PKEY_free(pkey);
+        return ok;
+    }
+
+    // 每块的IV = SHA256(nonce || index)的前16字节
+    // ChaCha20的IV前4字节是块计数器，需要置零，避免块内计数器溢出
+    void chunk_iv(const FileHeader &header, uint64_t index, uint8_t *iv)
+    {
+        uint8_t buf[NONCE_LENGTH + 8];
+        std::memcpy(buf, header.nonce, NONCE_LENGTH);
+        put_le<uint64_t>(buf + NONCE_LENGTH, index);
+        uint8_t digest[32];
+        EVP_Digest(buf, sizeof(buf), digest, nullptr, EVP_sha256(), nullptr);
+        std::memcpy(iv, digest, 16);
+        if (header.algorithm == CipherAlgorithm::ChaCha20)
+        {
+            std::memset(iv, 0, 4);
+        }
+    }
+
+    // 压缩容器的认证码还覆盖长度字段，防止压缩标记被篡改
+    bool chunk_tag(const DerivedKey &key, const FileHeader &header, uint64_t index, uint32_t stored,
+                   const uint8_t *cipher_text, size_t len, uint8_t *tag)
+    {
+        uint8_t meta[9 + STORED_LENGTH];
+        put_le<uint64_t>(meta, index);
+        meta[8] = index + 1 == header.chunk_count() ? 1 : 0;
+        put_le<uint32_t>(meta + 9, stored);
+        size_t meta_length = header.compressed() ? sizeof(meta) : 9;
+        return hmac_sha256(key.mac_key, {{header.mac, MAC_LENGTH}, {meta, meta_length}, {cipher_text, len}}, tag);
+    }
+
+    // 一个数据块，data中存放密文和紧随其后的认证码
+    struct Chunk
+    {
+        uint64_t index = 0;
+        // 密文的长度，压缩容器中可能小于明文长度
+        size_t length = 0;
+        // 压缩容器中的长度字段
+        uint32_t stored = 0;
+        std::vector<uint8_t> data;
+    };
+
+    // 压缩容器中块的长度字段是否合法
+    bool check_stored(const FileHeader &header, uint64_t index, uint32_t stored)
+    {
+        size_t plain_length = header.chunk_length(index);
+        size_t length = stored & ~STORED_COMPRESSED;
+        return stored & STORED_COMPRESSED ? length > 0 && length < plain_length : length == plain_length;
+    }
+
+    // 所有支持的算法都是流密码模式，加密和解密是同一个操作
+    // 一批中尚未开始的块少于线程数时，空闲的线程用于并行生成单块的密钥流
+    // 压缩容器中先压缩再加密，压缩没有收益的块保存原文。同一块的压缩和加密在同一个工作线程中完成，
+    // 多块同时在不同线程中处理，不再另设跨线程的压缩-加密流水线
+    bool encrypt_chunk(const DerivedKey &key, const FileHeader &header, Chunk &chunk, size_t keystream_threads,
+                       Compressor &compressor)
+    {
+        if (header.compressed())
+        {
+            std::string packed;
+            chunk.stored = (uint32_t)chunk.length;
+            if (compressor.compress(chunk.data.data(), chunk.length, packed))
+            {
+                chunk.length = packed.size();
+                chunk.stored = (uint32_t)chunk.length | STORED_COMPRESSED;
+                std::memcpy(chunk.data.data(), packed.data(), chunk.length);
+                chunk.data.resize(chunk.length + MAC_LENGTH);
+            }
+        }
+        uint8_t iv[16];
+        chunk_iv(header, chunk.index, iv);
+        KeystreamCipher cipher(header.algorithm, key.cipher_key, keystream_threads);
+        return cipher.apply(iv, chunk.data.data(), chunk.length) &&
+               chunk_tag(key, header, chunk.index, chunk.stored, chunk.data.data(), chunk.length,
+                         chunk.data.data() + chunk.length);
+    }
+
+    // 解密后data中只有明文，length为明文长度
+    bool decrypt_chunk(const DerivedKey &key, const FileHeader &header, Chunk &chunk, size_t keystream_threads,
+                       Compressor &compressor)
+    {
+        uint8_t iv[16], tag[MAC_LENGTH];
+        chunk_iv(header, chunk.index, iv);
+        if (!chunk_tag(key, header, chunk.index, chunk.stored, chunk.data.data(), chunk.length, tag) ||
+            CRYPTO_memcmp(tag, chunk.data.data() + chunk.length, MAC_LENGTH) != 0)
+        {
+            return false;
+        }
+        KeystreamCipher cipher(header.algorithm, key.cipher_key, keystream_threads);
+        if (!cipher.apply(iv, chunk.data.data(), chunk.length))
+        {
+            return false;
+        }
+        if (chunk.stored & STORED_COMPRESSED)
+        {
+            size_t plain_length = header.chunk_length(chunk.index);
+            std::string plain, message;
+            if (!compressor.decompress(chunk.data.data(), chunk.length, plain_length, plain, message) ||
+                plain.size() != plain_length)
+            {
+                return false;
+            }
+            chunk.length = plain_length;
+            chunk.data.assign(plain.begin(), plain.end());
+        }
+        return true;
+    }
+
+    // 常驻的工作线程，并行处理每批数据块，调用线程同时读写文件
+    class ChunkWorkers
+    {
+    public:
+        // task的第二个参数是每块可以再用于生成密钥流的线程数，第三个参数是该线程私有的压缩器
+        using Task = std::function<bool(Chunk &chunk, size_t keystream_threads, Compressor &compressor)>;
+
+        ChunkWorkers(size_t thread_count, int compress_level, Task task)
+            : m_task(std::move(task))
+        {
+            for (size_t i = 0; i < thread_count; i++)
+            {
+                m_threads.emplace_back([this, compress_level]()
+                                       { work(compress_level); });
+            }
+        }
+
+        ~ChunkWorkers()
+        {
+            wait();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopping = true;
+            }
+            m_cv.notify_all();
+            for (auto &t : m_threads)
+            {
+                t.join();
+            }
+        }
+
+        // 开始处理一批，立即返回，batch在wait返回前不能改动
+        void start(std::vector<Chunk> &batch)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_batch = &batch;
+                m_next = 0;
+                m_ok = true;
+                m_busy = m_threads.size();
+                m_round++;
+            }
+            m_cv.notify_all();
+        }
+
+        // 等待当前批结束，任意一块失败则返回false
+        bool wait()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done_cv.wait(lock, [this]()
+                           { return m_busy == 0; });
+            return m_ok;
+        }
+
+    private:
+        void work(int compress_level)
+        {
+            // 压缩上下文在同一个文件的所有数据块之间复用
+            Compressor compressor(compress_level);
+            uint64_t round = 0;
+            std::unique_lock<std::mutex> lock(m_mutex);
+            for (;;)
+            {
+                m_cv.wait(lock, [&]()
+                          { return m_stopping || m_round != round; });
+                if (m_stopping)
+                {
+                    return;
+                }
+                round = m_round;
+                while (m_ok && m_next < m_batch->size())
+                {
+                    // 包括这一块在内还剩unclaimed块，批尾和短批中多出的线程分给这些块生成密钥流
+                    size_t unclaimed = m_batch->size() - m_next;
+                    Chunk &chunk = (*m_batch)[m_next++];
+                    size_t keystream_threads = std::max<size_t>(1, m_threads.size() / unclaimed);
+                    lock.unlock();
+                    bool ok = m_task(chunk, keystream_threads, compressor);
+                    lock.lock();
+                    m_ok = m_ok && ok;
+                }
+                if (--m_busy == 0)
+                {
+                    m_done_cv.notify_all();
+                }
+            }
+        }
+
+    private:
+        Task m_task;
+        std::vector<std::thread> m_threads;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::condition_variable m_done_cv;
+        std::vector<Chunk> *m_batch = nullptr;
+        uint64_t m_round = 0;
+        size_t m_next = 0;
+        size_t m_busy = 0;
+        bool m_ok = true;
+        bool m_stopping = false;
+    };
+
+    // 从容器文件中顺序读取从first开始的至多count块
+    bool read_chunks(std::ifstream &ifs, const FileHeader &header, uint64_t first, uint64_t count,
+                     std::vector<Chunk> &batch)
+    {
+        batch.resize(count);
+        for (uint64_t i = 0; i < count; i++)
+        {
+            Chunk &chunk = batch[i];
+            chunk.index = first + i;
+            chunk.length = header.chunk_length(chunk.index);
+            chunk.stored = 0;
+            if (header.compressed())
+            {
+                uint8_t buf[STORED_LENGTH];
+                if (!ifs.read((char *)buf, STORED_LENGTH))
+                {
+                    return false;
+                }
+                chunk.stored = get_le<uint32_t>(buf);
+                if (!check_stored(header, chunk.index, chunk.stored))
+                {
+                    return false;
+                }
+                chunk.length = chunk.stored & ~STORED_COMPRESSED;
+            }
+            chunk.data.resize(chunk.length + MAC_LENGTH);
+            if (!ifs.read((char *)chunk.data.data(), chunk.data.size()))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 读取压缩容器末尾的块偏移索引，读取后文件指针的位置不确定
+    // 偏移必须严格递增且落在文件头和索引之间；索引本身没有认证码，
+    // 偏移被篡改时读到的块无法通过认证（认证码覆盖块序号），顺序解密时还会与实际偏移逐一比较
+    bool read_index(std::ifstream &ifs, const std::string &src_path, const FileHeader &header,
+                    std::vector<uint64_t> &offsets)
+    {
+        std::error_code ec;
+        uint64_t file_size = std::filesystem::file_size(src_path, ec);
+        uint64_t count = header.chunk_count();
+        if (ec || file_size < HEADER_LENGTH + header.index_length())
+        {
+            return false;
+        }
+        uint64_t index_begin = file_size - header.index_length();
+        std::vector<uint8_t> buf((size_t)header.index_length());
+        ifs.clear();
+        ifs.seekg((std::streamoff)index_begin);
+        if (!ifs.read((char *)buf.data(), buf.size()))
+        {
+            return false;
+        }
+        offsets.resize((size_t)count);
+        for (uint64_t i = 0; i < count; i++)
+        {
+            offsets[i] = get_le<uint64_t>(buf.data() + i * INDEX_ENTRY_LENGTH);
+            uint64_t min_offset = i ? offsets[i - 1] + STORED_LENGTH + MAC_LENGTH : HEADER_LENGTH;
+            if (offsets[i] < min_offset || offsets[i] + STORED_LENGTH + MAC_LENGTH > index_begin)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 读取并校验文件头，派生密钥
+    FileCrypterResult open_container(std::ifstream &ifs, const std::string &src_path, const std::string &password,
+                                     FileHeader &header, DerivedKey &key)
+    {
+        uint8_t buf[HEADER_LENGTH];
+        if (!ifs.read((char *)buf, HEADER_LENGTH) || !header.parse(buf))
+        {
+            return FileCrypterResult::failure("不是有效的加密文件");
+        }
+        // 压缩容器的长度无法预先计算，截断会在读取数据块时发现
+        std::error_code ec;
+        if (!header.compressed() && (std::filesystem::file_size(src_path, ec) != header.container_size() || ec))
+        {
+            return FileCrypterResult::failure("加密文件已被截断或损坏");
+        }
+        uint8_t mac[MAC_LENGTH];
+        if (!derive_key(password, header, key) ||
+            !hmac_sha256(key.mac_key, {{buf, HEADER_BODY_LENGTH}}, mac))
+        {
+            return FileCrypterResult::failure("密钥派生失败");
+        }
+        if (CRYPTO_memcmp(mac, header.mac, MAC_LENGTH) != 0)
+        {
+            return FileCrypterResult::failure("密码错误或文件头已损坏");
+        }
+        return FileCrypterResult::success();
+    }
+}
+
+FileCrypter::FileCrypter(const std::string &password, const FileCrypterOption &option)
+    : m_password(password), m_option(option)
+{
+    m_option.chunk_size = std::clamp(m_option.chunk_size, __min_chunk_size__, __max_chunk_size__);
+    m_option.compress_level = std::clamp(m_option.compress_level, Compressor::__min_level__, Compressor::__max_level__);
+}
+
+size_t FileCrypter::thread_count() const
+{
+    if (m_option.thread_count)
+    {
+        return m_option.thread_count;
+    }
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+FileCrypterResult FileCrypter::encrypt_file(const std::string &src_path, const std::string &dst_path,
+                                            const FileCrypterProgress &progress)
+{
+    std::error_code ec;
+    uint64_t plain_size = std::filesystem::file_size(src_path, ec);
+    std::ifstream ifs(src_path, std::ios::in | std::ios::binary);
+    if (ec || !ifs)
+    {
+        return FileCrypterResult::failure("无法打开文件：" + src_path);
+    }
+    std::ofstream ofs(dst_path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!ofs)
+    {
+        return FileCrypterResult::failure("无法写入文件：" + dst_path);
+    }
+    // 任意一步失败都删除已写出的部分密文
+    auto fail = [&](const std::string &message)
+    {
+        ofs.close();
+        std::error_code ec;
+        std::filesystem::remove(dst_path, ec);
+        return FileCrypterResult::failure(message);
+    };
+    // 生成文件头
+    FileHeader header;
+    header.version = m_option.compress ? __compressed_container_version__ : __container_version__;
+    header.flags = m_option.compress ? FLAG_COMPRESSED : 0;
+    header.algorithm = m_option.algorithm;
+    header.chunk_size = (uint32_t)m_option.chunk_size;
+    header.kdf_iterations = __kdf_iterations__;
+    header.plain_size = plain_size;
+    DerivedKey key;
+    uint8_t buf[HEADER_LENGTH];
+    if (RAND_bytes(header.salt, SALT_LENGTH) != 1 || RAND_bytes(header.nonce, NONCE_LENGTH) != 1)
+    {
+        return fail("生成随机数失败");
+    }
+    header.serialize_body(buf);
+    if (!derive_key(m_password, header, key) ||
+        !hmac_sha256(key.mac_key, {{buf, HEADER_BODY_LENGTH}}, header.mac))
+    {
+        return fail("密钥派生失败");
+    }
+    std::memcpy(buf + HEADER_BODY_LENGTH, header.mac, MAC_LENGTH);
+    ofs.write((const char *)buf, HEADER_LENGTH);
+
+    // 每批的块数为线程数的两倍，读取下一批的同时并行加密当前批
+    const size_t threads = thread_count();
+    const uint64_t chunk_count = header.chunk_count();
+    const uint64_t batch_size = threads * 2;
+    auto read_plain = [&](uint64_t first, std::vector<Chunk> &batch)
+    {
+        batch.resize((size_t)std::min(batch_size, chunk_count - first));
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            Chunk &chunk = batch[i];
+            chunk.index = first + i;
+            chunk.length = header.chunk_length(chunk.index);
+            chunk.data.resize(chunk.length + MAC_LENGTH);
+            if (!ifs.read((char *)chunk.data.data(), chunk.length))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+    std::vector<Chunk> cur, next;
+    if (!read_plain(0, cur))
+    {
+        return fail("读取文件失败：" + src_path);
+    }
+    // 压缩容器中各块的偏移，全部写完后追加在文件末尾
+    std::vector<uint8_t> index;
+    uint64_t offset = HEADER_LENGTH;
+    ChunkWorkers workers(threads, m_option.compress_level,
+                         [&](Chunk &chunk, size_t keystream_threads, Compressor &compressor)
+                         { return encrypt_chunk(key, header, chunk, keystream_threads, compressor); });
+    for (uint64_t first = 0; first < chunk_count;)
+    {
+        workers.start(cur);
+        uint64_t next_first = first + cur.size();
+        bool read_ok = read_plain(next_first, next);
+        if (!workers.wait())
+        {
+            return fail("加密失败");
+        }
+        if (!read_ok)
+        {
+            return fail("读取文件失败：" + src_path);
+        }
+        for (auto &chunk : cur)
+        {
+            if (header.compressed())
+            {
+                uint8_t stored[STORED_LENGTH];
+                put_le<uint32_t>(stored, chunk.stored);
+                ofs.write((const char *)stored, STORED_LENGTH);
+                index.resize(index.size() + INDEX_ENTRY_LENGTH);
+                put_le<uint64_t>(index.data() + index.size() - INDEX_ENTRY_LENGTH, offset);
+                offset += STORED_LENGTH + chunk.data.size();
+            }
+            ofs.write((const char *)chunk.data.data(), chunk.data.size());
+        }
+        if (!ofs)
+        {
+            return fail("无法写入文件：" + dst_path);
+        }
+        first = next_first;
+        if (progress)
+        {
+            progress(std::min<uint64_t>(first * header.chunk_size, plain_size), plain_size);
+        }
+        cur.swap(next);
+    }
+    ofs.write((const char *)index.data(), index.size());
+    ofs.close();
+    if (!ofs)
+    {
+        return fail("无法写入文件：" + dst_path);
+    }
+    return FileCrypterResult::success();
+}
+
+FileCrypterResult FileCrypter::decrypt_file(const std::string &src_path, const std::string &dst_path,
+                                            const FileCrypterProgress &progress)
+{
+    std::ifstream ifs(src_path, std::ios::in | std::ios::binary);
+    if (!ifs)
+    {
+        return FileCrypterResult::failure("无法打开文件：" + src_path);
+    }
+    FileHeader header;
+    DerivedKey key;
+    if (auto res = open_container(ifs, src_path, m_password, header, key); !res.ok)
+    {
+        return res;
+    }
+    std::ofstream ofs(dst_path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!ofs)
+    {
+        return FileCrypterResult::failure("无法写入文件：" + dst_path);
+    }
+    // 任意一块校验失败都删除已写出的部分明文
+    auto fail = [&](const std::string &message)
+    {
+        ofs.close();
+        std::error_code ec;
+        std::filesystem::remove(dst_path, ec);
+        return FileCrypterResult::failure(message);
+    };
+    const size_t threads = thread_count();
+    const uint64_t chunk_count = header.chunk_count();
+    const uint64_t batch_size = threads * 2;
+    std::vector<Chunk> cur, next;
+    if (!read_chunks(ifs, header, 0, std::min(batch_size, chunk_count), cur))
+    {
+        return fail("读取文件失败：" + src_path);
+    }
+    ChunkWorkers workers(threads, Compressor::__default_level__,
+                         [&](Chunk &chunk, size_t keystream_threads, Compressor &compressor)
+                         { return decrypt_chunk(key, header, chunk, keystream_threads, compressor); });
+    // 压缩容器中各块的实际偏移，最后与末尾的索引比较
+    std::vector<uint64_t> offsets;
+    uint64_t offset = HEADER_LENGTH;
+    for (uint64_t first = 0; first < chunk_count;)
+    {
+        if (header.compressed())
+        {
+            for (const auto &chunk : cur)
+            {
+                offsets.push_back(offset);
+                offset += STORED_LENGTH + chunk.data.size();
+            }
+        }
+        workers.start(cur);
+        uint64_t next_first = first + cur.size();
+        bool read_ok = read_chunks(ifs, header, next_first, std::min(batch_size, chunk_count - next_first), next);
+        if (!workers.wait())
+        {
+            return fail("数据块认证失败，文件已被篡改或损坏");
+        }
+        if (!read_ok)
+        {
+            return fail("读取文件失败：" + src_path);
+        }
+        for (auto &chunk : cur)
+        {
+            ofs.write((const char *)chunk.data.data(), chunk.length);
+        }
+        if (!ofs)
+        {
+            return fail("无法写入文件：" + dst_path);
+        }
+        first = next_first;
+        if (progress)
+        {
+            progress(std::min<uint64_t>(first * header.chunk_size, header.plain_size), header.plain_size);
+        }
+        cur.swap(next);
+    }
+    // 压缩容器在最后一块之后只有索引，且索引与实际偏移一致
+    if (header.compressed())
+    {
+        std::vector<uint64_t> index;
+        std::error_code ec;
+        if (std::filesystem::file_size(src_path, ec) != offset + header.index_length() || ec ||
+            !read_index(ifs, src_path, header, index) || index != offsets)
+        {
+            return fail("加密文件已损坏");
+        }
+    }
+    ofs.close();
+    if (!ofs)
+    {
+        return fail("无法写入文件：" + dst_path);
+    }
+    return FileCrypterResult::success();
+}
+
+FileCrypterResult FileCrypter::decrypt_range(const std::string &src_path, uint64_t offset, uint64_t length,
+                                             std::vector<uint8_t> &out)
+{
+    out.clear();
+    std::ifstream ifs(src_path, std::ios::in | std::ios::binary);
+    if (!ifs)
+    {
+        return FileCrypterResult::failure("无法打开文件：" + src_path);
+    }
+    FileHeader header;
+    DerivedKey key;
+    if (auto res = open_container(ifs, src_path, m_password, header, key); !res.ok)
+    {
+        return res;
+    }
+    if (offset >= header.plain_size || length == 0)
+    {
+        return FileCrypterResult::success();
+    }
+    length = std::min(length, header.plain_size - offset);
+    // 只读取覆盖目标区间的数据块
+    const uint64_t first = offset / header.chunk_size;
+    const uint64_t last = (offset + length - 1) / header.chunk_size;
+    if (header.compressed())
+    {
+        // 块长度不固定，从末尾的索引中查出第first块的位置
+        std::vector<uint64_t> offsets;
+        if (!read_index(ifs, src_path, header, offsets))
+        {
+            return FileCrypterResult::failure("加密文件已损坏");
+        }
+        ifs.seekg((std::streamoff)offsets[first]);
+    }
+    else
+    {
+        ifs.seekg((std::streamoff)header.chunk_offset(first));
+    }
+    const size_t threads = thread_count();
+    const uint64_t batch_size = threads * 2;
+    ChunkWorkers workers(threads, Compressor::__default_level__,
+                         [&](Chunk &chunk, size_t keystream_threads, Compressor &compressor)
+                         { return decrypt_chunk(key, header, chunk, keystream_threads, compressor); });
+    // 先解密并认证全部数据块，任意一块失败时不输出任何明文
+    std::vector<Chunk> chunks, batch;
+    for (uint64_t index = first; index <= last; index += batch.size())
+    {
+        if (!read_chunks(ifs, header, index, std::min(batch_size, last + 1 - index), batch))
+        {
+            return FileCrypterResult::failure("读取文件失败：" + src_path);
+        }
+        workers.start(batch);
+        if (!workers.wait())
+        {
+            return FileCrypterResult::failure("数据块认证失败，文件已被篡改或损坏");
+        }
+        std::move(batch.begin(), batch.end(), std::back_inserter(chunks));
+    }
+    out.reserve((size_t)length);
+    for (const auto &chunk : chunks)
+    {
+        uint64_t chunk_begin = chunk.index * header.chunk_size;
+        uint64_t begin = std::max(offset, chunk_begin) - chunk_begin;
+        uint64_t end = std::min(offset + length, chunk_begin + chunk.length) - chunk_begin;
+        out.insert(out.end(), chunk.data.begin() + begin, chunk.data.begin() + end);
+    }
+    return FileCrypterResult::success();
+}
@@ -1,5 +1,6 @@
+#include <set>
+#include <mutex>
 #include <fstream>
-#include <thread>
 #include <filesystem>
 
 #include <fmt/core.h>
@@ -11,63 +12,109 @@
 #include <ciftl/etc/etc.h>
 
 #include "cryption/hash_form.h"
+#include "etc/local_path.h"
+#include "io/io_scheduler.h"
+#include "service/hash_daemon.h"
 #include "ui_hash_form.h"
 
+const std::vector<std::pair<std::string, FileReadMode>> HashForm::__supported_read_mode__ = {
+    {"普通", FileReadMode::BUFFERED},
+    {"批量扫描", FileReadMode::BULK_SCAN},
+    {"直接读取", FileReadMode::DIRECT},
+    {"异步读取", FileReadMode::ASYNC}
+};
+
 HashForm::HashForm(QWidget *parent) : QWidget(parent),
-                                      ui(new Ui::HashForm)
+                                      ui(new Ui::HashForm),
+                                      m_job_queue(std::make_unique<JobQueue>()),
+                                      m_rate_limiter(std::make_shared<RateLimiter>(0))
 {
     ui->setupUi(this);
+    m_rate_limiter->set_rate((uint64_t)ui->spinBoxRateLimit->value() * 1024 * 1024);
     connect(this, SIGNAL(operation_start()), this, SLOT(start_operation()));
     connect(this, SIGNAL(operation_end()), this, SLOT(end_operation()));
     connect(this, SIGNAL(file_progress_update(size_t)), this, SLOT(update_file_progress(size_t)));
     connect(this, SIGNAL(total_progress_update(size_t)), this, SLOT(update_total_progress(size_t)));
     connect(this, SIGNAL(main_text_update(QString)), this, SLOT(update_main_text(QString)));
+    connect(this, SIGNAL(watch_end(size_t)), this, SLOT(end_watch(size_t)));
     connect(ui->pushButtonOpen, SIGNAL(clicked()), this, SLOT(choose_files()));
     connect(ui->pushButtonCopy, SIGNAL(clicked()), this, SLOT(copy_result()));
     connect(ui->pushButtonSaveAs, SIGNAL(clicked()), this, SLOT(save_as()));
     connect(ui->pushButtonClear, SIGNAL(clicked()), this, SLOT(clear_text()));
+    connect(ui->pushButtonPause, SIGNAL(clicked()), this, SLOT(pause_or_resume()));
+    connect(ui->pushButtonCancel, SIGNAL(clicked()), this, SLOT(cancel_all()));
+    connect(ui->pushButtonWatch, SIGNAL(clicked()), this, SLOT(start_or_stop_watch()));
+    connect(ui->spinBoxRateLimit, SIGNAL(valueChanged(int)), this, SLOT(update_rate_limit(int)));
+    // 加载下拉框
+    for (const auto &iter : __supported_read_mode__)
+    {
+        ui->comboBoxReadMode->addItem(QString::fromStdString(iter.first));
+    }
 }
 
 HashForm::~HashForm()
 {
+    // 监视线程会提交任务，先停止监视，再取消并等待所有任务结束，任务中会访问界面发出的信号
+    stop_watch();
+    m_job_queue = nullptr;
     delete ui;
 }
 
-std::vector<std::pair<std::string, std::shared_ptr<ciftl::IHasher>>> HashForm::generate_hasher_vec()
+std::vector<std::string> HashForm::checked_hasher_names()
 {
-    std::vector<std::pair<std::string, std::shared_ptr<ciftl::IHasher>>> hasher_vec;
+    std::vector<std::string> hasher_names;
     if (ui->checkBoxMD5->isChecked())
     {
-        hasher_vec.push_back({"MD5", std::make_shared<ciftl::MD5Hasher>()});
+        hasher_names.push_back("MD5");
     }
     if (ui->checkBoxSha1->isChecked())
     {
-        hasher_vec.push_back({"Sha1", std::make_shared<ciftl::Sha1Hasher>()});
+        hasher_names.push_back("Sha1");
     }
     if (ui->checkBoxSha256->isChecked())
     {
-        hasher_vec.push_back({"Sha256", std::make_shared<ciftl::Sha256Hasher>()});
+        hasher_names.push_back("Sha256");
     }
     if (ui->checkBoxSha512->isChecked())
     {
-        hasher_vec.push_back({"Sha512", std::make_shared<ciftl::Sha512Hasher>()});
+        hasher_names.push_back("Sha512");
     }
-    return hasher_vec;
+    return hasher_names;
+}
+
+FileReadOption HashForm::checked_read_option()
+{
+    FileReadOption read_option;
+    read_option.mode = __supported_read_mode__[ui->comboBoxReadMode->currentIndex()].second;
+    // 所有任务共享同一个限速器，限制的是整个窗口的总速度
+    read_option.rate_limiter = m_rate_limiter;
+    return read_option;
+}
+
+void HashForm::update_rate_limit(int val)
+{
+    // 正在进行的任务同样生效
+    m_rate_limiter->set_rate((uint64_t)val * 1024 * 1024);
 }
 
 void HashForm::start_operation()
 {
-    this->setEnabled(false);
+    m_job_count++;
+    ui->pushButtonPause->setEnabled(true);
+    ui->pushButtonCancel->setEnabled(true);
 }
 
 void HashForm::end_operation()
 {
-    this->setEnabled(true);
-    if (m_thread)
+    if (m_job_count && --m_job_count)
     {
-        m_thread->join();
-        m_thread = nullptr;
+        return;
     }
+    // 所有任务都已结束
+    m_job_queue->resume();
+    ui->pushButtonPause->setText("暂停");
+    ui->pushButtonPause->setEnabled(false);
+    ui->pushButtonCancel->setEnabled(false);
 }
 
 void HashForm::update_file_progress(size_t val)
@@ -100,13 +147,6 @@ void HashForm::copy_result()
     clipboard->setText(ui->plainTextEdit->toPlainText());
 }
 
-inline std::string to_local_path(const QString &str)
-{
-    auto local_8bit = str.toLocal8Bit();
-    auto local_8bit_str = std::string(local_8bit.constData(), local_8bit.size());
-    return local_8bit_str;
-};
-
 void HashForm::save_as()
 {
     QString q_file_path = QFileDialog::getSaveFileName(nullptr, "保存文件", QDir::homePath(), "文本文件 (*.txt)");
@@ -122,78 +162,427 @@ void HashForm::choose_files()
     do_hash(q_file_paths);
 }
 
+void HashForm::pause_or_resume()
+{
+    if (m_job_queue->paused())
+    {
+        m_job_queue->resume();
+        ui->pushButtonPause->setText("暂停");
+    }
+    else
+    {
+        m_job_queue->pause();
+        ui->pushButtonPause->setText("继续");
+    }
+}
+
+void HashForm::cancel_all()
+{
+    m_job_queue->cancel_all();
+    ui->pushButtonPause->setText("暂停");
+}
+
+FileReadStatus HashForm::digest_file(FileReader &reader, JobControl &control, const std::vector<std::string> &hasher_names,
+                                     const std::string &file_path, size_t file_size,
+                                     std::vector<std::pair<std::string, std::string>> &digests)
+{
+    emit file_progress_update(0L);
+    return HashEngine::digest_file(reader, hasher_names, file_path, [&](size_t sum)
+                                   {
+        emit file_progress_update((size_t)(100.0 * sum / file_size));
+        // 暂停时在这里阻塞，取消后读完当前块即停止
+        return control.checkpoint(); }, digests);
+}
+
+QStringList HashForm::result_lines(const QString &q_file_path, uint64_t file_size, FileReadStatus status,
+                                   const std::vector<std::pair<std::string, std::string>> &digests, bool shared,
+                                   const std::string &note)
+{
+    QStringList lines;
+    // 标题和文件大小
+    QString title = QString("<b>文件名: ") + q_file_path + "</b>";
+    QString file_size_banner =
+        QString::fromStdString(fmt::format(std::locale("zh_CN.UTF-8"), "<b>文件大小:</b> {:L} Bytes", file_size));
+    lines.append(title);
+    lines.append(file_size_banner);
+    if (status == FileReadStatus::OK)
+    {
+        for (const auto &digest : digests)
+        {
+            lines.append(QString::fromStdString(fmt::format("<b>{}:</b> {}", digest.first, digest.second)));
+        }
+        if (shared)
+        {
+            lines.append("<i>结果来自守护进程的缓存或其他请求的读取</i>");
+        }
+    }
+    else if (status == FileReadStatus::CANCELLED)
+    {
+        lines.append("已取消：" + q_file_path);
+    }
+    else if (status == FileReadStatus::OPEN_FAILED)
+    {
+        // 处理文件打开失败的情况
+        lines.append("无法打开文件：" + q_file_path);
+    }
+    else
+    {
+        lines.append("读取文件失败：" + q_file_path);
+    }
+    // 选择的读取方式不可用时说明实际使用的方式
+    if (!note.empty())
+    {
+        lines.append("<i>" + QString::fromStdString(note) + "</i>");
+    }
+    return lines;
+}
+
+QStringList HashForm::hash_file(FileReader &reader, JobControl &control, const std::vector<std::string> &hasher_names,
+                                const QString &q_file_path, const std::string &file_path)
+{
+    QStringList lines;
+    // 文件名不存在则跳过
+    if (std::filesystem::exists(file_path))
+    {
+        size_t file_size = std::filesystem::file_size(file_path);
+        std::vector<std::pair<std::string, std::string>> digests;
+        auto status = digest_file(reader, control, hasher_names, file_path, file_size, digests);
+        lines = result_lines(q_file_path, file_size, status, digests, false, reader.note());
+    }
+    lines.append("");
+    return lines;
+}
+
+void HashForm::hash_by_daemon(HashClient &client, JobControl &control, const QStringList &file_paths,
+                              const std::vector<std::string> &local_paths, const FileReadOption &read_option,
+                              const std::vector<std::string> &hasher_names)
+{
+    HashRequest request;
+    request.file_paths = local_paths;
+    request.hasher_names = hasher_names;
+    request.mode = read_option.mode;
+    request.rate_limit = read_option.rate_limiter ? read_option.rate_limiter->rate() : 0;
+    request.priority = control.priority();
+    size_t finished = 0;
+    HashCallback callback;
+    callback.on_progress = [this](size_t percent)
+    {
+        emit file_progress_update(percent);
+    };
+    callback.on_result = [&](const HashResult &result)
+    {
+        QStringList lines;
+        // 与本地计算一样跳过不存在的文件
+        if (result.status != FileReadStatus::OPEN_FAILED || std::filesystem::exists(local_paths[result.index]))
+        {
+            lines = result_lines(file_paths[result.index], result.size, result.status, result.digests, result.shared,
+                                 result.note);
+        }
+        lines.append("");
+        for (const auto &line : lines)
+        {
+            emit main_text_update(line);
+        }
+        emit total_progress_update((size_t)(100.0 * ++finished / file_paths.size()));
+    };
+    std::string message;
+    // 暂停时只停止接收结果，取消时断开连接，守护进程随即取消该请求
+    if (!client.hash(request, callback, [&]()
+                     { return !control.checkpoint(); }, message) &&
+        !control.cancelled())
+    {
+        emit main_text_update(QString("<b>守护进程出错：</b>") + QString::fromLocal8Bit(message.c_str()));
+    }
+}
+
 void HashForm::do_hash(QStringList file_paths)
 {
-    std::function<void()> func = [this, file_paths]()
+    if (file_paths.isEmpty())
+    {
+        return;
+    }
+    // 读取方式、限速和哈希算法在界面线程中确定，任务运行期间修改界面不影响已提交的任务
+    FileReadOption read_option = checked_read_option();
+    std::vector<std::string> hasher_names = checked_hasher_names();
+    JobPriority priority = ui->checkBoxUrgent->isChecked() ? JobPriority::URGENT : JobPriority::NORMAL;
+    JobTask func = [this, file_paths, read_option, hasher_names](JobControl &control) mutable
     {
-        emit operation_start();
+        if (!control.cancelled())
+        {
+            emit total_progress_update(0L);
+            std::vector<std::string> local_paths;
+            for (const auto &q_file_path : file_paths)
+            {
+                local_paths.push_back(to_local_path(q_file_path));
+            }
+            // 守护进程在运行时交给它计算，与其他实例和命令行共享读取和摘要缓存
+            HashClient client;
+            std::string message;
+            if (client.connect(HashDaemon::default_socket_path(), message))
+            {
+                hash_by_daemon(client, control, file_paths, local_paths, read_option, hasher_names);
+                if (control.cancelled())
+                {
+                    emit main_text_update(QString("<b>校验任务已取消</b>"));
+                }
+                emit operation_end();
+                return;
+            }
+            // 按所在磁盘分组，不同磁盘并行读取
+            IoScheduler scheduler(local_paths);
+            // 多通道时每条通道各有一个缓冲区，减小块大小以控制内存占用
+            if (scheduler.lane_count() > 1)
+            {
+                read_option.block_size = 1024 * 1024 * 8;
+            }
+            // 限速等待期间也能响应取消
+            read_option.cancelled = [&control]()
+            { return control.cancelled(); };
+            std::vector<std::unique_ptr<FileReader>> readers(scheduler.lane_count());
+            std::mutex output_mutex;
+            size_t finished = 0;
+            scheduler.run([&](size_t lane, size_t i, size_t next)
+                          {
+                // 取消后跳过剩余的文件
+                if (control.cancelled())
+                {
+                    return;
+                }
+                // 同一通道的文件共用一个读取缓冲区
+                if (!readers[lane])
+                {
+                    readers[lane] = std::make_unique<FileReader>(read_option);
+                }
+                readers[lane]->prefetch(next != IoScheduler::__no_file__ ? local_paths[next] : "");
+                QStringList lines = hash_file(*readers[lane], control, hasher_names, file_paths[i], local_paths[i]);
+                // 一个文件的结果连续输出，不与其他通道交错
+                std::lock_guard<std::mutex> lock(output_mutex);
+                for (const auto &line : lines)
+                {
+                    emit main_text_update(line);
+                }
+                emit total_progress_update((size_t)(100.0 * ++finished / file_paths.size())); });
+        }
+        if (control.cancelled())
+        {
+            emit main_text_update(QString("<b>校验任务已取消</b>"));
+        }
+        emit operation_end();
+    };
+    emit operation_start();
+    m_job_queue->submit(func, priority);
+}
+
+namespace
+{
+    // 对比目录树和清单，找出清单之后新建或修改过的文件，以及清单中已经不存在的文件
+    // 只读取文件的元数据，不读取内容
+    std::vector<FileChange> scan_folder(const FolderWatcher &watcher, const HashManifest &manifest)
+    {
+        std::vector<FileChange> changes;
+        std::set<std::string> existing;
+        const std::string &root = watcher.root();
+        std::error_code ec;
+        for (std::filesystem::recursive_directory_iterator
+                 iter(root, std::filesystem::directory_options::skip_permission_denied, ec),
+             end;
+             !ec && iter != end; iter.increment(ec))
+        {
+            if (watcher.stopping())
+            {
+                return {};
+            }
+            if (HashManifest::is_manifest_file(iter->path().filename().string()))
+            {
+                continue;
+            }
+            std::string file_path = iter->path().string();
+            // 遍历得到的路径都以root开头，按路径成分计算相对路径，根目录为"/"时同样适用
+            std::string path = iter->path().lexically_relative(root).string();
+            uint64_t size;
+            int64_t mtime;
+            if (!HashManifest::file_stat(file_path, size, mtime))
+            {
+                continue;
+            }
+            existing.insert(path);
+            if (!manifest.up_to_date(path, size, mtime))
+            {
+                changes.push_back({path, FileChangeKind::MODIFIED});
+            }
+        }
+        for (const auto &path : manifest.paths())
+        {
+            if (!existing.count(path))
+            {
+                changes.push_back({path, FileChangeKind::REMOVED});
+            }
+        }
+        return changes;
+    }
+}
+
+void HashForm::start_or_stop_watch()
+{
+    if (m_watch_thread)
+    {
+        stop_watch();
+        return;
+    }
+    QString q_root = QFileDialog::getExistingDirectory(nullptr, "选择文件夹", QDir::homePath());
+    if (q_root.isEmpty())
+    {
+        return;
+    }
+    FileReadOption read_option = checked_read_option();
+    std::vector<std::string> hasher_names = checked_hasher_names();
+    m_folder_watcher = std::make_unique<FolderWatcher>(to_local_path(q_root));
+    // 清单写在监视的文件夹中，不能让清单的写入再触发事件
+    m_folder_watcher->ignore_prefix(HashManifest::__manifest_name__);
+    size_t generation = ++m_watch_generation;
+    m_watch_thread = std::make_unique<std::thread>([this, read_option, hasher_names, generation]()
+                                                   {
+        watch_folder(m_folder_watcher->root(), read_option, hasher_names);
+        emit watch_end(generation); });
+    ui->pushButtonWatch->setText("停止监视");
+}
+
+void HashForm::stop_watch()
+{
+    if (!m_watch_thread)
+    {
+        return;
+    }
+    m_folder_watcher->stop();
+    m_watch_thread->join();
+    m_watch_thread = nullptr;
+    m_folder_watcher = nullptr;
+    ui->pushButtonWatch->setText("监视文件夹");
+}
+
+void HashForm::end_watch(size_t generation)
+{
+    // 监视线程自行退出（例如无法监视）时回收线程。信号是排队送达的，
+    // 主动停止后又开始了新的监视时，旧线程的信号不能停止新的监视
+    if (generation != m_watch_generation)
+    {
+        return;
+    }
+    stop_watch();
+}
+
+void HashForm::watch_folder(const std::string &root, const FileReadOption &read_option,
+                            const std::vector<std::string> &hasher_names)
+{
+    QString q_root = QString::fromLocal8Bit(root.c_str());
+    std::string message;
+    auto manifest = std::make_shared<HashManifest>(root);
+    // 先开始监视再扫描，扫描期间发生的变化不会遗漏
+    if (!manifest->load(message) || !m_folder_watcher->start(message))
+    {
+        emit main_text_update(QString("<b>无法监视文件夹：</b>") + QString::fromLocal8Bit(message.c_str()));
+        return;
+    }
+    emit main_text_update(QString("<b>开始监视：</b>%1（清单中已有%2个文件）").arg(q_root).arg(manifest->size()));
+    std::vector<FileChange> changes = {{"", FileChangeKind::RESCAN}};
+    do
+    {
+        // 事件丢失时退回到按元数据对账，仍然只重新计算变化的文件
+        for (const auto &change : changes)
+        {
+            if (change.kind == FileChangeKind::RESCAN)
+            {
+                changes = scan_folder(*m_folder_watcher, *manifest);
+                break;
+            }
+        }
+        std::vector<std::string> modified;
+        for (const auto &change : changes)
+        {
+            if (change.kind == FileChangeKind::MODIFIED)
+            {
+                modified.push_back(change.path);
+            }
+            else if (change.kind == FileChangeKind::REMOVED)
+            {
+                if (!manifest->remove(change.path, message))
+                {
+                    emit main_text_update(QString::fromLocal8Bit(message.c_str()));
+                }
+                emit main_text_update(QString("<b>已删除：</b>") + QString::fromLocal8Bit(change.path.c_str()));
+            }
+        }
+        if (!modified.empty())
+        {
+            submit_watch_job(manifest, modified, read_option, hasher_names);
+        }
+    } while (m_folder_watcher->wait_changes(changes));
+    // 已提交的任务仍然持有清单，之后的更新继续写入日志
+    if (!manifest->compact(message))
+    {
+        emit main_text_update(QString::fromLocal8Bit(message.c_str()));
+    }
+    emit main_text_update(QString("<b>已停止监视：</b>") + q_root);
+}
+
+void HashForm::submit_watch_job(const std::shared_ptr<HashManifest> &manifest, const std::vector<std::string> &paths,
+                                const FileReadOption &read_option, const std::vector<std::string> &hasher_names)
+{
+    // 任务可能在监视停止后才执行，预先算好完整路径
+    std::vector<std::pair<std::string, std::string>> files;
+    for (const auto &path : paths)
+    {
+        files.push_back({path, m_folder_watcher->full_path(path)});
+    }
+    JobTask func = [this, manifest, files, read_option, hasher_names](JobControl &control)
+    {
+        FileReadOption option = read_option;
+        option.cancelled = [&control]()
+        { return control.cancelled(); };
+        FileReader reader(option);
         emit total_progress_update(0L);
-        // 遍历文件执行
-        for (size_t i = 0; i < (size_t)file_paths.size(); i++)
+        size_t finished = 0;
+        for (const auto &[path, file_path] : files)
         {
-            auto q_file_path = file_paths[i];
-            auto file_path = to_local_path(q_file_path);
-            // 文件名不存在则跳过
-            if (std::filesystem::exists(file_path))
+            if (control.cancelled())
             {
-                // 标题和文件大小
-                QString title = QString("<b>文件名: ") + q_file_path + "</b>";
-                size_t file_size = std::filesystem::file_size(file_path);
-                QString file_size_banner =
-                    QString::fromStdString(fmt::format(std::locale("zh_CN.UTF-8"), "<b>文件大小:</b> {:L} Bytes", file_size));
-                emit main_text_update(title);
-                emit main_text_update(file_size_banner);
-                // 哈希算法
-                auto hasher_vec = generate_hasher_vec();
-                // 打开文件
-                std::ifstream ifs(file_path, std::ios::in | std::ios::binary);
-                if (ifs)
+                break;
+            }
+            QString q_path = QString::fromLocal8Bit(path.c_str());
+            // 大小和修改时间在读取之前取得，读取期间文件又被修改时会再收到一次事件
+            ManifestEntry entry;
+            if (HashManifest::file_stat(file_path, entry.size, entry.mtime) &&
+                !manifest->up_to_date(path, entry.size, entry.mtime))
+            {
+                auto status = digest_file(reader, control, hasher_names, file_path, entry.size, entry.digests);
+                std::string message;
+                if (status == FileReadStatus::OK && manifest->update(path, entry, message))
                 {
-                    size_t sum = 0;
-                    // 以32MB为一个块进行计算来减少IO
-                    constexpr size_t block_size = 1024 * 1024 * 32;
-                    ciftl::ByteVector tmp(block_size);
-                    emit file_progress_update(0L);
-                    // 边读取边计算hash
-                    for (;;)
-                    {
-                        ifs.read((char *)tmp.data(), block_size);
-                        if (auto cnt = ifs.gcount(); cnt)
-                        {
-                            for (auto iter : hasher_vec)
-                            {
-                                iter.second->update(tmp.data(), cnt);
-                            }
-                            sum += cnt;
-                            emit file_progress_update((size_t)(100.0 * sum / file_size));
-                        }
-                        else
-                        {
-                            break;
-                        }
-                    }
-                    // 以十六进制格式输出
-                    ciftl::HexEncoding hex;
-                    for (auto iter : hasher_vec)
+                    emit main_text_update(QString("<b>已更新：</b>") + q_path);
+                    for (const auto &digest : entry.digests)
                     {
-                        auto res = iter.second->finalize();
-                        QString message = QString::fromStdString(fmt::format("<b>{}:</b> {}", iter.first, hex.encode(res)));
-                        emit main_text_update(message);
+                        emit main_text_update(
+                            QString::fromStdString(fmt::format("<b>{}:</b> {}", digest.first, digest.second)));
                     }
                 }
-                else
+                else if (status == FileReadStatus::OK)
+                {
+                    emit main_text_update(QString::fromLocal8Bit(message.c_str()));
+                }
+                else if (status != FileReadStatus::CANCELLED)
                 {
-                    // 处理文件打开失败的情况
-                    emit main_text_update("无法打开文件：" + q_file_path);
+                    // 文件在读取前被删除或正在被独占写入，之后的事件会再次处理
+                    emit main_text_update("读取文件失败：" + q_path);
                 }
             }
-            emit main_text_update("");
-            emit total_progress_update((size_t)(100.0 * (i + 1) / file_paths.size()));
+            emit total_progress_update((size_t)(100.0 * ++finished / files.size()));
+        }
+        if (control.cancelled())
+        {
+            emit main_text_update(QString("<b>监视任务已取消，未更新的文件在重新监视时会再次计算</b>"));
         }
         emit operation_end();
     };
-    if (!m_thread)
-    {
-        m_thread = std::make_unique<std::thread>(func);
-    }
+    emit operation_start();
+    m_job_queue->submit(func, JobPriority::NORMAL);
 }
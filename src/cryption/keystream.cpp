@@ -0,0 +1,330 @@
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+
+#include <openssl/evp.h>
+
+#include "cryption/keystream.h"
+
+namespace
+{
+    const EVP_CIPHER *evp_cipher(CipherAlgorithm algorithm)
+    {
+        switch (algorithm)
+        {
+        case CipherAlgorithm::ChaCha20:
+            return EVP_chacha20();
+        case CipherAlgorithm::AES128OFB:
+            return EVP_aes_128_ofb();
+        case CipherAlgorithm::AES192OFB:
+            return EVP_aes_192_ofb();
+        case CipherAlgorithm::AES256OFB:
+            return EVP_aes_256_ofb();
+#ifndef OPENSSL_NO_SM4
+        case CipherAlgorithm::SM4OFB:
+            return EVP_sm4_ofb();
+#endif
+        default:
+            return nullptr;
+        }
+    }
+
+    bool evp_apply(const EVP_CIPHER *cipher, const uint8_t *key, const uint8_t *iv, uint8_t *data, size_t len)
+    {
+        EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+        bool ok = ctx && EVP_EncryptInit_ex(ctx, cipher, nullptr, key, iv) == 1;
+        // EVP接口的长度是int，超长输入分段处理
+        constexpr size_t step = 1 << 30;
+        for (size_t pos = 0; ok && pos < len; pos += step)
+        {
+            int n = (int)std::min(step, len - pos), out_len = 0;
+            ok = EVP_EncryptUpdate(ctx, data + pos, &out_len, data + pos, n) == 1 && out_len == n;
+        }
+        EVP_CIPHER_CTX_free(ctx);
+        return ok;
+    }
+
+    // 常驻的密钥流线程，进程内所有KeystreamCipher共用，apply不再每次创建和回收线程
+    class KeystreamPool
+    {
+    public:
+        static KeystreamPool &instance()
+        {
+            // 调用线程自己也参与计算，另外的线程数比核心数少一个，至少一个供OFB的生产者使用
+            static KeystreamPool pool(std::max<size_t>(2, std::thread::hardware_concurrency()) - 1);
+            return pool;
+        }
+
+        ~KeystreamPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopping = true;
+            }
+            m_cv.notify_all();
+            for (auto &t : m_threads)
+            {
+                t.join();
+            }
+        }
+
+        // 交给空闲线程执行，立即返回。任务不能等待其他池内任务，否则线程全忙时会互相等待
+        void post(std::function<void()> task)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_tasks.push_back(std::move(task));
+            }
+            m_cv.notify_one();
+        }
+
+        size_t size() const
+        {
+            return m_threads.size();
+        }
+
+    private:
+        explicit KeystreamPool(size_t thread_count)
+        {
+            for (size_t i = 0; i < thread_count; i++)
+            {
+                m_threads.emplace_back([this]()
+                                       { work(); });
+            }
+        }
+
+        void work()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            for (;;)
+            {
+                m_cv.wait(lock, [this]()
+                          { return m_stopping || !m_tasks.empty(); });
+                if (m_tasks.empty())
+                {
+                    return;
+                }
+                auto task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+                lock.unlock();
+                task();
+                lock.lock();
+            }
+        }
+
+    private:
+        std::vector<std::thread> m_threads;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        std::deque<std::function<void()>> m_tasks;
+        bool m_stopping = false;
+    };
+
+    void xor_bytes(uint8_t *dst, const uint8_t *src, size_t len)
+    {
+        size_t i = 0;
+        for (; i + 8 <= len; i += 8)
+        {
+            uint64_t a, b;
+            std::memcpy(&a, dst + i, 8);
+            std::memcpy(&b, src + i, 8);
+            a ^= b;
+            std::memcpy(dst + i, &a, 8);
+        }
+        for (; i < len; i++)
+        {
+            dst[i] ^= src[i];
+        }
+    }
+}
+
+KeystreamCipher::KeystreamCipher(CipherAlgorithm algorithm, const uint8_t *key, size_t thread_count)
+    : m_algorithm(algorithm), m_key(key), m_thread_count(thread_count)
+{
+    if (!m_thread_count)
+    {
+        m_thread_count = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+}
+
+bool KeystreamCipher::is_supported(CipherAlgorithm algorithm)
+{
+    return evp_cipher(algorithm) != nullptr;
+}
+
+bool KeystreamCipher::apply(const uint8_t *iv, uint8_t *data, size_t len) const
+{
+    if (m_algorithm == CipherAlgorithm::ChaCha20)
+    {
+        if (m_thread_count > 1 && len >= __chacha20_parallel_threshold__)
+        {
+            return apply_chacha20_parallel(iv, data, len);
+        }
+    }
+    else if (m_thread_count > 1 && len >= __ofb_pipeline_threshold__)
+    {
+        return apply_ofb_pipelined(iv, data, len);
+    }
+    return apply_sequential(iv, data, len);
+}
+
+bool KeystreamCipher::apply_sequential(const uint8_t *iv, uint8_t *data, size_t len) const
+{
+    const EVP_CIPHER *cipher = evp_cipher(m_algorithm);
+    return cipher && evp_apply(cipher, m_key, iv, data, len);
+}
+
+bool KeystreamCipher::apply_chacha20_parallel(const uint8_t *iv, uint8_t *data, size_t len) const
+{
+    // OpenSSL的ChaCha20 IV前4字节是小端的块计数器，后12字节是nonce
+    uint32_t counter = (uint32_t)iv[0] | (uint32_t)iv[1] << 8 | (uint32_t)iv[2] << 16 | (uint32_t)iv[3] << 24;
+    uint64_t block_count = (len + 63) / 64;
+    // 计数器溢出时OpenSSL会进位到nonce，这种情况不切分
+    if (counter + block_count > UINT32_MAX + 1ULL)
+    {
+        return apply_sequential(iv, data, len);
+    }
+    // 调用线程和池中的线程从同一组段中认领，池中线程晚到时段已经处理完，直接返回而不会访问data
+    struct Job
+    {
+        uint8_t iv[16];
+        const uint8_t *key;
+        uint8_t *data;
+        size_t len;
+        size_t segment;
+        size_t segment_count;
+        uint32_t counter;
+        std::atomic<size_t> next{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t done = 0;
+        bool ok = true;
+
+        void run()
+        {
+            for (size_t i; (i = next++) < segment_count;)
+            {
+                size_t pos = i * segment;
+                uint8_t segment_iv[16];
+                std::memcpy(segment_iv, iv, 16);
+                uint32_t segment_counter = counter + (uint32_t)(pos / 64);
+                for (int b = 0; b < 4; b++)
+                {
+                    segment_iv[b] = (uint8_t)(segment_counter >> (8 * b));
+                }
+                bool segment_ok = evp_apply(EVP_chacha20(), key, segment_iv, data + pos, std::min(segment, len - pos));
+                std::lock_guard<std::mutex> lock(mutex);
+                ok = ok && segment_ok;
+                if (++done == segment_count)
+                {
+                    cv.notify_all();
+                }
+            }
+        }
+    };
+    auto job = std::make_shared<Job>();
+    std::memcpy(job->iv, iv, 16);
+    job->key = m_key;
+    job->data = data;
+    job->len = len;
+    job->counter = counter;
+    size_t threads = std::min(m_thread_count, len / __chacha20_min_segment__);
+    // 每段按64字节对齐，保证各段起点正好落在块边界上
+    job->segment = ((len + threads - 1) / threads + 63) / 64 * 64;
+    job->segment_count = (len + job->segment - 1) / job->segment;
+    KeystreamPool &pool = KeystreamPool::instance();
+    for (size_t i = 1; i < std::min(job->segment_count, pool.size() + 1); i++)
+    {
+        pool.post([job]()
+                  { job->run(); });
+    }
+    job->run();
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->cv.wait(lock, [&]()
+                 { return job->done == job->segment_count; });
+    return job->ok;
+}
+
+bool KeystreamCipher::apply_ofb_pipelined(const uint8_t *iv, uint8_t *data, size_t len) const
+{
+    const EVP_CIPHER *cipher = evp_cipher(m_algorithm);
+    if (!cipher)
+    {
+        return false;
+    }
+    // 池中的线程作为生产者把密钥流写入环形缓冲区，调用线程取出后异或到数据上
+    constexpr size_t slot_count = 4;
+    const size_t total_slots = (len + __ofb_pipeline_slot__ - 1) / __ofb_pipeline_slot__;
+    std::vector<uint8_t> ring(slot_count * __ofb_pipeline_slot__);
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t produced = 0, consumed = 0;
+    bool ok = true;
+    bool finished = false;
+
+    KeystreamPool::instance().post([&]()
+                                   {
+        EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+        bool producer_ok = ctx && EVP_EncryptInit_ex(ctx, cipher, nullptr, m_key, iv) == 1;
+        for (size_t i = 0; i < total_slots; i++)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&]()
+                        { return produced - consumed < slot_count || !ok; });
+                if (!ok)
+                {
+                    break;
+                }
+            }
+            // 对全零加密即得到OFB的密钥流
+            uint8_t *slot = ring.data() + (i % slot_count) * __ofb_pipeline_slot__;
+            int n = (int)std::min(__ofb_pipeline_slot__, len - i * __ofb_pipeline_slot__), out_len = 0;
+            std::memset(slot, 0, n);
+            producer_ok = producer_ok && EVP_EncryptUpdate(ctx, slot, &out_len, slot, n) == 1 && out_len == n;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ok = ok && producer_ok;
+                produced++;
+            }
+            cv.notify_all();
+        }
+        EVP_CIPHER_CTX_free(ctx);
+        // 通知之后不能再访问调用线程栈上的变量
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+        cv.notify_all(); });
+
+    for (size_t i = 0; i < total_slots; i++)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&]()
+                    { return produced > i || !ok; });
+            if (!ok)
+            {
+                break;
+            }
+        }
+        size_t pos = i * __ofb_pipeline_slot__;
+        xor_bytes(data + pos, ring.data() + (i % slot_count) * __ofb_pipeline_slot__,
+                  std::min(__ofb_pipeline_slot__, len - pos));
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            consumed++;
+        }
+        cv.notify_all();
+    }
+    // 生产者结束后才能释放环形缓冲区
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&]()
+            { return finished; });
+    return ok;
+}
@@ -0,0 +1,195 @@
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <cstring>
+#include <algorithm>
+#include <condition_variable>
+
+#include <fmt/core.h>
+
+#include "cryption/compressor.h"
+#include "cryption/string_pipeline.h"
+
+StringPipeline::StringPipeline(const StringCrypterFactory &crypter_factory, const std::string &password,
+                               const StringCompressOption &option, size_t thread_count)
+    : m_crypter_factory(crypter_factory), m_password(password), m_option(option), m_thread_count(thread_count)
+{
+    if (!m_thread_count)
+    {
+        m_thread_count = std::max<size_t>(2, std::thread::hardware_concurrency());
+    }
+}
+
+void StringPipeline::run(size_t count, const StageFactory &first_stage, const StageFactory &second_stage)
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<uint8_t> ready(count, 0);
+    std::atomic<size_t> first_next = 0, second_next = 0;
+    auto first_worker = [&]()
+    {
+        auto stage = first_stage();
+        for (size_t i; (i = first_next++) < count;)
+        {
+            stage(i);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ready[i] = 1;
+            }
+            cv.notify_all();
+        }
+    };
+    auto second_worker = [&]()
+    {
+        auto stage = second_stage();
+        for (size_t i; (i = second_next++) < count;)
+        {
+            // 第一阶段按行号顺序取行，等待的行一定会在有限时间内完成
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&]()
+                        { return ready[i] != 0; });
+            }
+            stage(i);
+        }
+    };
+    // 两个阶段平分线程，每个阶段至少一个线程
+    const size_t threads = std::min(m_thread_count, std::max<size_t>(2, count * 2));
+    const size_t first_threads = std::max<size_t>(1, threads / 2);
+    const size_t second_threads = std::max<size_t>(1, threads - first_threads);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < first_threads; i++)
+    {
+        workers.emplace_back(first_worker);
+    }
+    for (size_t i = 1; i < second_threads; i++)
+    {
+        workers.emplace_back(second_worker);
+    }
+    second_worker();
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void StringPipeline::encrypt(std::vector<CrypterTableData> &rows)
+{
+    const size_t prefix_length = std::strlen(__compressed_prefix__);
+    // 第一阶段的输出：待加密的内容以及是否经过压缩
+    std::vector<std::string> payloads(rows.size());
+    std::vector<uint8_t> compressed(rows.size(), 0);
+    StageFactory compress_stage = [&]() -> std::function<void(size_t)>
+    {
+        if (!m_option.enabled)
+        {
+            return [&](size_t i)
+            { payloads[i] = rows[i].src_text; };
+        }
+        auto compressor = std::make_shared<Compressor>(m_option.level, m_option.dictionary);
+        return [&, compressor](size_t i)
+        {
+            const std::string &src = rows[i].src_text;
+            // 密文长度随明文长度增长，帧加上前缀比原文短才有收益
+            compressed[i] = compressor->compress((const uint8_t *)src.data(), src.size(), payloads[i]) &&
+                            !payloads[i].empty() && payloads[i].size() + prefix_length < src.size();
+            if (!compressed[i])
+            {
+                payloads[i] = src;
+            }
+        };
+    };
+    StageFactory encrypt_stage = [&]() -> std::function<void(size_t)>
+    {
+        auto crypter = m_crypter_factory();
+        return [&, crypter](size_t i)
+        {
+            CrypterTableData &item = rows[i];
+            auto res = crypter->encrypt(payloads[i], m_password);
+            if (res.is_ok())
+            {
+                item.res_text = compressed[i] ? __compressed_prefix__ + res.ok().value() : res.ok().value();
+                item.res_mes = compressed[i]
+                                   ? fmt::format("成功（压缩至{}%）", 100 * payloads[i].size() / std::max<size_t>(1, item.src_text.size()))
+                                   : "成功";
+            }
+            else
+            {
+                item.res_text.clear();
+                item.res_mes =
+                    fmt::format("{}: {}", res.error().value().error_code(), res.error().value().error_message());
+            }
+            // 压缩后的内容不再需要
+            std::string().swap(payloads[i]);
+        };
+    };
+    run(rows.size(), compress_stage, encrypt_stage);
+}
+
+void StringPipeline::decrypt(std::vector<CrypterTableData> &rows)
+{
+    const size_t prefix_length = std::strlen(__compressed_prefix__);
+    // 第一阶段的输出：解密后的内容以及是否需要解压，解密失败的行已经写好结果
+    std::vector<std::string> payloads(rows.size());
+    std::vector<uint8_t> compressed(rows.size(), 0);
+    std::vector<uint8_t> failed(rows.size(), 0);
+    StageFactory decrypt_stage = [&]() -> std::function<void(size_t)>
+    {
+        auto crypter = m_crypter_factory();
+        return [&, crypter](size_t i)
+        {
+            CrypterTableData &item = rows[i];
+            const std::string &src = item.src_text;
+            compressed[i] = src.compare(0, prefix_length, __compressed_prefix__) == 0;
+            auto res = crypter->decrypt(compressed[i] ? src.substr(prefix_length) : src, m_password);
+            if (res.is_ok())
+            {
+                payloads[i] = res.ok().value();
+            }
+            else
+            {
+                failed[i] = 1;
+                item.res_text.clear();
+                item.res_mes =
+                    fmt::format("{}: {}", res.error().value().error_code(), res.error().value().error_message());
+            }
+        };
+    };
+    StageFactory decompress_stage = [&]() -> std::function<void(size_t)>
+    {
+        // 没有压缩过的行不需要解压器，第一次遇到压缩的行时才创建
+        auto compressor = std::make_shared<std::unique_ptr<Compressor>>();
+        return [&, compressor](size_t i)
+        {
+            if (failed[i])
+            {
+                return;
+            }
+            CrypterTableData &item = rows[i];
+            if (!compressed[i])
+            {
+                item.res_text = std::move(payloads[i]);
+                item.res_mes = "成功";
+                return;
+            }
+            if (!*compressor)
+            {
+                *compressor = std::make_unique<Compressor>(m_option.level, m_option.dictionary);
+            }
+            const std::string &frame = payloads[i];
+            std::string message;
+            if ((*compressor)->decompress((const uint8_t *)frame.data(), frame.size(), __max_plain_size__, item.res_text,
+                                          message))
+            {
+                item.res_mes = "成功";
+            }
+            else
+            {
+                item.res_text.clear();
+                item.res_mes = message;
+            }
+            std::string().swap(payloads[i]);
+        };
+    };
+    run(rows.size(), decrypt_stage, decompress_stage);
+}
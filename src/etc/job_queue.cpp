@@ -0,0 +1,174 @@
+#include <algorithm>
+
+#include "etc/job_queue.h"
+
+JobControl::JobControl(JobQueue *queue, JobPriority priority)
+    : m_queue(queue), m_priority(priority), m_cancelled(false)
+{
+}
+
+void JobControl::cancel()
+{
+    m_cancelled = true;
+    // 唤醒在检查点处阻塞的线程
+    m_queue->notify();
+}
+
+bool JobControl::cancelled() const
+{
+    return m_cancelled;
+}
+
+JobPriority JobControl::priority() const
+{
+    return m_priority;
+}
+
+bool JobControl::checkpoint()
+{
+    if (m_cancelled)
+    {
+        return false;
+    }
+    return m_queue->wait_runnable(*this);
+}
+
+JobQueue::JobQueue(size_t worker_count)
+{
+    worker_count = std::max<size_t>(1, worker_count);
+    for (size_t i = 0; i < worker_count; i++)
+    {
+        m_workers.emplace_back(&JobQueue::worker_loop, this, false);
+    }
+    m_workers.emplace_back(&JobQueue::worker_loop, this, true);
+}
+
+JobQueue::~JobQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        for (const auto &control : m_running)
+        {
+            control->m_cancelled = true;
+        }
+    }
+    m_cv.notify_all();
+    for (auto &worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+std::shared_ptr<JobControl> JobQueue::submit(JobTask task, JobPriority priority)
+{
+    auto control = std::make_shared<JobControl>(this, priority);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (priority == JobPriority::URGENT)
+        {
+            m_urgent_jobs.push_back({control, std::move(task)});
+            m_urgent_active++;
+        }
+        else
+        {
+            m_normal_jobs.push_back({control, std::move(task)});
+        }
+    }
+    m_cv.notify_all();
+    return control;
+}
+
+void JobQueue::pause()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_paused = true;
+}
+
+void JobQueue::resume()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_paused = false;
+    }
+    m_cv.notify_all();
+}
+
+bool JobQueue::paused() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_paused;
+}
+
+void JobQueue::cancel_all()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto *jobs : {&m_urgent_jobs, &m_normal_jobs})
+        {
+            for (const auto &job : *jobs)
+            {
+                job.control->m_cancelled = true;
+            }
+        }
+        for (const auto &control : m_running)
+        {
+            control->m_cancelled = true;
+        }
+        // 已取消的任务需要被调度才能结束
+        m_paused = false;
+    }
+    m_cv.notify_all();
+}
+
+void JobQueue::worker_loop(bool urgent_only)
+{
+    for (;;)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [&]()
+                      { return m_stopping ||
+                               (!m_paused && (!m_urgent_jobs.empty() ||
+                                              (!urgent_only && !m_normal_jobs.empty() && !m_urgent_active))); });
+            if (m_stopping)
+            {
+                return;
+            }
+            auto &jobs = m_urgent_jobs.empty() ? m_normal_jobs : m_urgent_jobs;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+            m_running.push_back(job.control);
+        }
+        job.task(*job.control);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running.erase(std::find(m_running.begin(), m_running.end(), job.control));
+            if (job.control->m_priority == JobPriority::URGENT)
+            {
+                m_urgent_active--;
+            }
+        }
+        // 紧急任务结束后让出的普通任务可以继续
+        m_cv.notify_all();
+    }
+}
+
+bool JobQueue::wait_runnable(const JobControl &control)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [&]()
+              { return control.m_cancelled || m_stopping ||
+                       (!m_paused && (control.m_priority == JobPriority::URGENT || !m_urgent_active)); });
+    return !control.m_cancelled && !m_stopping;
+}
+
+void JobQueue::notify()
+{
+    // 加锁保证等待方不会错过这次唤醒
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_cv.notify_all();
+}
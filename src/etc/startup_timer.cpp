@@ -0,0 +1,33 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include <QElapsedTimer>
+
+#include "etc/startup_timer.h"
+
+namespace
+{
+    QElapsedTimer startup_timer;
+    qint64 last_mark_ns = 0;
+    bool timing_enabled = false;
+}
+
+void StartupTimer::start()
+{
+    // 此时QApplication还没有创建，直接读取环境变量
+    timing_enabled = std::getenv("CIFTL_STARTUP_TIMING") != nullptr;
+    startup_timer.start();
+    last_mark_ns = 0;
+}
+
+void StartupTimer::mark(const char *phase)
+{
+    if (!timing_enabled || !startup_timer.isValid())
+    {
+        return;
+    }
+    qint64 now_ns = startup_timer.nsecsElapsed();
+    std::fprintf(stderr, "[startup] %-24s %9.3f ms (+%.3f ms)\n",
+                 phase, now_ns / 1e6, (now_ns - last_mark_ns) / 1e6);
+    last_mark_ns = now_ns;
+}
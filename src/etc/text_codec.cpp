@@ -0,0 +1,565 @@
+#include <array>
+#include <cstdlib>
+#include <cstring>
+
+#include "etc/text_codec.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define TEXT_CODEC_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define TEXT_CODEC_TARGET_SSSE3
+#define TEXT_CODEC_TARGET_AVX2
+#else
+#define TEXT_CODEC_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TEXT_CODEC_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define TEXT_CODEC_NEON
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+    constexpr char HEX_DIGITS[] = "0123456789abcdef";
+    constexpr char BASE64_DIGITS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    constexpr uint8_t INVALID = 0xff;
+
+    constexpr std::array<uint8_t, 256> make_hex_table()
+    {
+        std::array<uint8_t, 256> table{};
+        for (auto &v : table)
+        {
+            v = INVALID;
+        }
+        for (int i = 0; i < 10; i++)
+        {
+            table['0' + i] = (uint8_t)i;
+        }
+        for (int i = 0; i < 6; i++)
+        {
+            table['a' + i] = (uint8_t)(10 + i);
+            table['A' + i] = (uint8_t)(10 + i);
+        }
+        return table;
+    }
+
+    constexpr std::array<uint8_t, 256> make_base64_table()
+    {
+        std::array<uint8_t, 256> table{};
+        for (auto &v : table)
+        {
+            v = INVALID;
+        }
+        for (int i = 0; i < 64; i++)
+        {
+            table[(uint8_t)BASE64_DIGITS[i]] = (uint8_t)i;
+        }
+        return table;
+    }
+
+    constexpr std::array<uint8_t, 256> HEX_TABLE = make_hex_table();
+    constexpr std::array<uint8_t, 256> BASE64_TABLE = make_base64_table();
+
+    // 各实现只处理整块的数据，返回已处理的输入长度，剩余部分交给标量实现
+    using EncodeBlocks = size_t (*)(const uint8_t *in, size_t len, char *out);
+    using DecodeBlocks = size_t (*)(const char *in, size_t len, uint8_t *out);
+
+    size_t no_blocks_encode(const uint8_t *, size_t, char *)
+    {
+        return 0;
+    }
+
+    size_t no_blocks_decode(const char *, size_t, uint8_t *)
+    {
+        return 0;
+    }
+
+    // ---------------- 标量实现 ----------------
+
+    void hex_encode_scalar(const uint8_t *in, size_t len, char *out)
+    {
+        for (size_t i = 0; i < len; i++)
+        {
+            out[2 * i] = HEX_DIGITS[in[i] >> 4];
+            out[2 * i + 1] = HEX_DIGITS[in[i] & 0x0f];
+        }
+    }
+
+    bool hex_decode_scalar(const char *in, size_t len, uint8_t *out)
+    {
+        for (size_t i = 0; i < len; i += 2)
+        {
+            uint8_t hi = HEX_TABLE[(uint8_t)in[i]], lo = HEX_TABLE[(uint8_t)in[i + 1]];
+            if (hi == INVALID || lo == INVALID)
+            {
+                return false;
+            }
+            out[i / 2] = (uint8_t)(hi << 4 | lo);
+        }
+        return true;
+    }
+
+    void base64_encode_scalar(const uint8_t *in, size_t len, char *out)
+    {
+        size_t i = 0;
+        for (; i + 3 <= len; i += 3, out += 4)
+        {
+            uint32_t v = (uint32_t)in[i] << 16 | (uint32_t)in[i + 1] << 8 | in[i + 2];
+            out[0] = BASE64_DIGITS[v >> 18];
+            out[1] = BASE64_DIGITS[(v >> 12) & 0x3f];
+            out[2] = BASE64_DIGITS[(v >> 6) & 0x3f];
+            out[3] = BASE64_DIGITS[v & 0x3f];
+        }
+        if (len - i == 1)
+        {
+            uint32_t v = (uint32_t)in[i] << 16;
+            out[0] = BASE64_DIGITS[v >> 18];
+            out[1] = BASE64_DIGITS[(v >> 12) & 0x3f];
+            out[2] = out[3] = '=';
+        }
+        else if (len - i == 2)
+        {
+            uint32_t v = (uint32_t)in[i] << 16 | (uint32_t)in[i + 1] << 8;
+            out[0] = BASE64_DIGITS[v >> 18];
+            out[1] = BASE64_DIGITS[(v >> 12) & 0x3f];
+            out[2] = BASE64_DIGITS[(v >> 6) & 0x3f];
+            out[3] = '=';
+        }
+    }
+
+    // 解码不含填充的完整4字符组
+    bool base64_decode_scalar(const char *in, size_t len, uint8_t *out)
+    {
+        for (size_t i = 0; i < len; i += 4, out += 3)
+        {
+            uint8_t a = BASE64_TABLE[(uint8_t)in[i]], b = BASE64_TABLE[(uint8_t)in[i + 1]],
+                    c = BASE64_TABLE[(uint8_t)in[i + 2]], d = BASE64_TABLE[(uint8_t)in[i + 3]];
+            if ((a | b | c | d) & 0xc0)
+            {
+                return false;
+            }
+            uint32_t v = (uint32_t)a << 18 | (uint32_t)b << 12 | (uint32_t)c << 6 | d;
+            out[0] = (uint8_t)(v >> 16);
+            out[1] = (uint8_t)(v >> 8);
+            out[2] = (uint8_t)v;
+        }
+        return true;
+    }
+
+#ifdef TEXT_CODEC_X86
+    // ---------------- SSSE3 ----------------
+
+    TEXT_CODEC_TARGET_SSSE3 size_t hex_encode_ssse3(const uint8_t *in, size_t len, char *out)
+    {
+        const __m128i lut = _mm_loadu_si128((const __m128i *)HEX_DIGITS);
+        const __m128i mask = _mm_set1_epi8(0x0f);
+        size_t i = 0;
+        for (; i + 16 <= len; i += 16)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+            __m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+            __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(v, mask));
+            _mm_storeu_si128((__m128i *)(out + 2 * i), _mm_unpacklo_epi8(hi, lo));
+            _mm_storeu_si128((__m128i *)(out + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+        }
+        return i;
+    }
+
+    // 字节是否位于[lo, hi]，大于0x7f的字节按有符号比较为负数，不会落入任何区间
+    inline __m128i in_range_sse(__m128i v, char lo, char hi)
+    {
+        return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)), _mm_cmpgt_epi8(_mm_set1_epi8(hi + 1), v));
+    }
+
+    // 把16个十六进制字符转换为半字节，非法字符使valid对应位为0
+    TEXT_CODEC_TARGET_SSSE3 inline __m128i hex_nibbles_sse(__m128i c, int &valid)
+    {
+        __m128i digit = in_range_sse(c, '0', '9');
+        __m128i lower = in_range_sse(c, 'a', 'f');
+        __m128i upper = in_range_sse(c, 'A', 'F');
+        __m128i shift = _mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8(-'0')),
+                                     _mm_or_si128(_mm_and_si128(lower, _mm_set1_epi8(10 - 'a')),
+                                                  _mm_and_si128(upper, _mm_set1_epi8(10 - 'A'))));
+        valid &= _mm_movemask_epi8(_mm_or_si128(digit, _mm_or_si128(lower, upper)));
+        return _mm_add_epi8(c, shift);
+    }
+
+    TEXT_CODEC_TARGET_SSSE3 size_t hex_decode_ssse3(const char *in, size_t len, uint8_t *out)
+    {
+        // 每16位中高字节在前：hi * 16 + lo
+        const __m128i weight = _mm_set1_epi16(0x0110);
+        size_t i = 0;
+        for (; i + 32 <= len; i += 32)
+        {
+            int valid = 0xffff;
+            __m128i a = hex_nibbles_sse(_mm_loadu_si128((const __m128i *)(in + i)), valid);
+            __m128i b = hex_nibbles_sse(_mm_loadu_si128((const __m128i *)(in + i + 16)), valid);
+            if (valid != 0xffff)
+            {
+                break;
+            }
+            __m128i bytes = _mm_packus_epi16(_mm_maddubs_epi16(a, weight), _mm_maddubs_epi16(b, weight));
+            _mm_storeu_si128((__m128i *)(out + i / 2), bytes);
+        }
+        return i;
+    }
+
+    // 12字节输入扩展为16个6位索引后映射到Base64字母表
+    TEXT_CODEC_TARGET_SSSE3 inline __m128i base64_encode_lanes_sse(__m128i v)
+    {
+        v = _mm_shuffle_epi8(v, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+        __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+        __m128i t1 = _mm_mullo_epi16(_mm_and_si128(v, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+        __m128i indices = _mm_or_si128(t0, t1);
+        // 0..25 -> 'A'，26..51 -> 'a'，52..61 -> '0'，62 -> '+'，63 -> '/'
+        __m128i reduced = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        reduced = _mm_or_si128(reduced, _mm_and_si128(less, _mm_set1_epi8(13)));
+        const __m128i shift_lut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                                '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                                '/' - 63, 'A', 0, 0);
+        return _mm_add_epi8(_mm_shuffle_epi8(shift_lut, reduced), indices);
+    }
+
+    TEXT_CODEC_TARGET_SSSE3 size_t base64_encode_ssse3(const uint8_t *in, size_t len, char *out)
+    {
+        size_t i = 0;
+        // 每次读取16字节但只使用前12字节
+        for (; i + 16 <= len; i += 12, out += 16)
+        {
+            _mm_storeu_si128((__m128i *)out, base64_encode_lanes_sse(_mm_loadu_si128((const __m128i *)(in + i))));
+        }
+        return i;
+    }
+
+    // 16个Base64字符转换为6位的值
+    TEXT_CODEC_TARGET_SSSE3 inline __m128i base64_values_sse(__m128i c, int &valid)
+    {
+        __m128i upper = in_range_sse(c, 'A', 'Z');
+        __m128i lower = in_range_sse(c, 'a', 'z');
+        __m128i digit = in_range_sse(c, '0', '9');
+        __m128i plus = _mm_cmpeq_epi8(c, _mm_set1_epi8('+'));
+        __m128i slash = _mm_cmpeq_epi8(c, _mm_set1_epi8('/'));
+        __m128i shift = _mm_or_si128(
+            _mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-'A')), _mm_and_si128(lower, _mm_set1_epi8(26 - 'a'))),
+            _mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8(52 - '0')),
+                         _mm_or_si128(_mm_and_si128(plus, _mm_set1_epi8(62 - '+')),
+                                      _mm_and_si128(slash, _mm_set1_epi8(63 - '/')))));
+        valid &= _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, _mm_or_si128(plus, slash))));
+        return _mm_add_epi8(c, shift);
+    }
+
+    // 16个6位的值合并为12字节，位于结果的低12字节
+    TEXT_CODEC_TARGET_SSSE3 inline __m128i base64_pack_sse(__m128i values)
+    {
+        __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+        return _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    }
+
+    TEXT_CODEC_TARGET_SSSE3 size_t base64_decode_ssse3(const char *in, size_t len, uint8_t *out)
+    {
+        size_t i = 0;
+        // 写出16字节但只前进12字节，至少再留一组保证不越界
+        for (; i + 24 <= len; i += 16, out += 12)
+        {
+            int valid = 0xffff;
+            __m128i values = base64_values_sse(_mm_loadu_si128((const __m128i *)(in + i)), valid);
+            if (valid != 0xffff)
+            {
+                break;
+            }
+            _mm_storeu_si128((__m128i *)out, base64_pack_sse(values));
+        }
+        return i;
+    }
+
+    // ---------------- AVX2 ----------------
+
+    TEXT_CODEC_TARGET_AVX2 inline __m256i in_range_avx2(__m256i v, char lo, char hi)
+    {
+        return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1)),
+                                _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v));
+    }
+
+    TEXT_CODEC_TARGET_AVX2 size_t hex_encode_avx2(const uint8_t *in, size_t len, char *out)
+    {
+        const __m256i lut = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)HEX_DIGITS));
+        const __m256i mask = _mm256_set1_epi8(0x0f);
+        size_t i = 0;
+        for (; i + 32 <= len; i += 32)
+        {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(in + i));
+            __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+            __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, mask));
+            // unpack在128位通道内进行，需要重新排列通道
+            __m256i a = _mm256_unpacklo_epi8(hi, lo);
+            __m256i b = _mm256_unpackhi_epi8(hi, lo);
+            _mm256_storeu_si256((__m256i *)(out + 2 * i), _mm256_permute2x128_si256(a, b, 0x20));
+            _mm256_storeu_si256((__m256i *)(out + 2 * i + 32), _mm256_permute2x128_si256(a, b, 0x31));
+        }
+        return i + hex_encode_ssse3(in + i, len - i, out + 2 * i);
+    }
+
+    TEXT_CODEC_TARGET_AVX2 inline __m256i hex_nibbles_avx2(__m256i c, uint32_t &valid)
+    {
+        __m256i digit = in_range_avx2(c, '0', '9');
+        __m256i lower = in_range_avx2(c, 'a', 'f');
+        __m256i upper = in_range_avx2(c, 'A', 'F');
+        __m256i shift = _mm256_or_si256(_mm256_and_si256(digit, _mm256_set1_epi8(-'0')),
+                                        _mm256_or_si256(_mm256_and_si256(lower, _mm256_set1_epi8(10 - 'a')),
+                                                        _mm256_and_si256(upper, _mm256_set1_epi8(10 - 'A'))));
+        valid &= (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(digit, _mm256_or_si256(lower, upper)));
+        return _mm256_add_epi8(c, shift);
+    }
+
+    TEXT_CODEC_TARGET_AVX2 size_t hex_decode_avx2(const char *in, size_t len, uint8_t *out)
+    {
+        const __m256i weight = _mm256_set1_epi16(0x0110);
+        size_t i = 0;
+        for (; i + 64 <= len; i += 64)
+        {
+            uint32_t valid = 0xffffffff;
+            __m256i a = hex_nibbles_avx2(_mm256_loadu_si256((const __m256i *)(in + i)), valid);
+            __m256i b = hex_nibbles_avx2(_mm256_loadu_si256((const __m256i *)(in + i + 32)), valid);
+            if (valid != 0xffffffff)
+            {
+                break;
+            }
+            // packus在通道内交错，按64位重新排列
+            __m256i bytes = _mm256_packus_epi16(_mm256_maddubs_epi16(a, weight), _mm256_maddubs_epi16(b, weight));
+            _mm256_storeu_si256((__m256i *)(out + i / 2), _mm256_permute4x64_epi64(bytes, 0xd8));
+        }
+        return i + hex_decode_ssse3(in + i, len - i, out + i / 2);
+    }
+
+    TEXT_CODEC_TARGET_AVX2 size_t base64_encode_avx2(const uint8_t *in, size_t len, char *out)
+    {
+        size_t i = 0;
+        // 两个通道各取12字节，第二个通道的读取末端为i + 28
+        for (; i + 28 <= len; i += 24, out += 32)
+        {
+            __m128i lo = _mm_loadu_si128((const __m128i *)(in + i));
+            __m128i hi = _mm_loadu_si128((const __m128i *)(in + i + 12));
+            __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+            v = _mm256_shuffle_epi8(v, _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                                        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+            __m256i t0 = _mm256_mulhi_epu16(_mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00)),
+                                            _mm256_set1_epi32(0x04000040));
+            __m256i t1 = _mm256_mullo_epi16(_mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0)),
+                                            _mm256_set1_epi32(0x01000010));
+            __m256i indices = _mm256_or_si256(t0, t1);
+            __m256i reduced = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+            __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+            reduced = _mm256_or_si256(reduced, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+            const __m256i shift_lut = _mm256_setr_epi8(
+                'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+                'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+            _mm256_storeu_si256((__m256i *)out, _mm256_add_epi8(_mm256_shuffle_epi8(shift_lut, reduced), indices));
+        }
+        return i + base64_encode_ssse3(in + i, len - i, out);
+    }
+
+    TEXT_CODEC_TARGET_AVX2 size_t base64_decode_avx2(const char *in, size_t len, uint8_t *out)
+    {
+        size_t i = 0;
+        // 写出32字节但只前进24字节
+        for (; i + 44 <= len; i += 32, out += 24)
+        {
+            __m256i c = _mm256_loadu_si256((const __m256i *)(in + i));
+            __m256i upper = in_range_avx2(c, 'A', 'Z');
+            __m256i lower = in_range_avx2(c, 'a', 'z');
+            __m256i digit = in_range_avx2(c, '0', '9');
+            __m256i plus = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('+'));
+            __m256i slash = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('/'));
+            __m256i valid = _mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(digit, _mm256_or_si256(plus, slash)));
+            if ((uint32_t)_mm256_movemask_epi8(valid) != 0xffffffff)
+            {
+                break;
+            }
+            __m256i shift = _mm256_or_si256(
+                _mm256_or_si256(_mm256_and_si256(upper, _mm256_set1_epi8(-'A')),
+                                _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a'))),
+                _mm256_or_si256(_mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')),
+                                _mm256_or_si256(_mm256_and_si256(plus, _mm256_set1_epi8(62 - '+')),
+                                                _mm256_and_si256(slash, _mm256_set1_epi8(63 - '/')))));
+            __m256i values = _mm256_add_epi8(c, shift);
+            __m256i merged = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+            merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+            merged = _mm256_shuffle_epi8(merged, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                                                  2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+            // 两个通道各12字节，拼接为连续的24字节
+            merged = _mm256_permutevar8x32_epi32(merged, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+            _mm256_storeu_si256((__m256i *)out, merged);
+        }
+        return i + base64_decode_ssse3(in + i, len - i, out);
+    }
+
+    bool cpu_has_ssse3()
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 9)) != 0;
+#else
+        return __builtin_cpu_supports("ssse3");
+#endif
+    }
+
+    bool cpu_has_avx2()
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 1);
+        // 还需要操作系统保存YMM寄存器
+        bool os_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        return os_avx && (info[1] & (1 << 5));
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif // TEXT_CODEC_X86
+
+#ifdef TEXT_CODEC_NEON
+    // ---------------- NEON ----------------
+
+    size_t hex_encode_neon(const uint8_t *in, size_t len, char *out)
+    {
+        const uint8x16_t lut = vld1q_u8((const uint8_t *)HEX_DIGITS);
+        size_t i = 0;
+        for (; i + 16 <= len; i += 16)
+        {
+            uint8x16_t v = vld1q_u8(in + i);
+            uint8x16x2_t chars;
+            chars.val[0] = vqtbl1q_u8(lut, vshrq_n_u8(v, 4));
+            chars.val[1] = vqtbl1q_u8(lut, vandq_u8(v, vdupq_n_u8(0x0f)));
+            // 交错存储高低半字节对应的字符
+            vst2q_u8((uint8_t *)out + 2 * i, chars);
+        }
+        return i;
+    }
+#endif // TEXT_CODEC_NEON
+
+    // 运行时选择的实现
+    struct CodecDispatch
+    {
+        const char *level = "scalar";
+        EncodeBlocks hex_encode = no_blocks_encode;
+        DecodeBlocks hex_decode = no_blocks_decode;
+        EncodeBlocks base64_encode = no_blocks_encode;
+        DecodeBlocks base64_decode = no_blocks_decode;
+    };
+
+    const CodecDispatch &dispatch()
+    {
+        static const CodecDispatch instance = []()
+        {
+            CodecDispatch d;
+            // 环境变量CIFTL_TEXT_CODEC可以把实现限制在某一级以下，用于测试和性能对比
+            const char *env = std::getenv("CIFTL_TEXT_CODEC");
+            std::string_view limit = env ? env : "";
+            if (limit == "scalar")
+            {
+                return d;
+            }
+#ifdef TEXT_CODEC_X86
+            if (cpu_has_avx2() && limit != "ssse3")
+            {
+                d = {"avx2", hex_encode_avx2, hex_decode_avx2, base64_encode_avx2, base64_decode_avx2};
+            }
+            else if (cpu_has_ssse3())
+            {
+                d = {"ssse3", hex_encode_ssse3, hex_decode_ssse3, base64_encode_ssse3, base64_decode_ssse3};
+            }
+#elif defined(TEXT_CODEC_NEON)
+            d.level = "neon";
+            d.hex_encode = hex_encode_neon;
+#endif
+            return d;
+        }();
+        return instance;
+    }
+}
+
+std::string HexCodec::encode(const uint8_t *data, size_t len)
+{
+    std::string res(len * 2, '\0');
+    size_t done = dispatch().hex_encode(data, len, res.data());
+    hex_encode_scalar(data + done, len - done, res.data() + 2 * done);
+    return res;
+}
+
+bool HexCodec::decode(std::string_view text, std::vector<uint8_t> &out)
+{
+    if (text.size() % 2)
+    {
+        return false;
+    }
+    out.resize(text.size() / 2);
+    size_t done = dispatch().hex_decode(text.data(), text.size(), out.data());
+    if (!hex_decode_scalar(text.data() + done, text.size() - done, out.data() + done / 2))
+    {
+        out.clear();
+        return false;
+    }
+    return true;
+}
+
+std::string Base64Codec::encode(const uint8_t *data, size_t len)
+{
+    std::string res((len + 2) / 3 * 4, '\0');
+    size_t done = dispatch().base64_encode(data, len, res.data());
+    base64_encode_scalar(data + done, len - done, res.data() + done / 3 * 4);
+    return res;
+}
+
+bool Base64Codec::decode(std::string_view text, std::vector<uint8_t> &out)
+{
+    if (text.size() % 4)
+    {
+        return false;
+    }
+    // 最后一组可能带有填充，单独处理
+    size_t padding = 0;
+    if (!text.empty() && text.back() == '=')
+    {
+        padding = text[text.size() - 2] == '=' ? 2 : 1;
+    }
+    size_t body = padding ? text.size() - 4 : text.size();
+    out.resize(text.size() / 4 * 3 - padding);
+    size_t done = dispatch().base64_decode(text.data(), body, out.data());
+    if (!base64_decode_scalar(text.data() + done, body - done, out.data() + done / 4 * 3))
+    {
+        out.clear();
+        return false;
+    }
+    if (padding)
+    {
+        const char *tail = text.data() + body;
+        uint8_t a = BASE64_TABLE[(uint8_t)tail[0]], b = BASE64_TABLE[(uint8_t)tail[1]];
+        uint8_t c = padding == 1 ? BASE64_TABLE[(uint8_t)tail[2]] : 0;
+        // 填充位必须为零
+        if ((a | b | c) & 0xc0 || (padding == 2 && (b & 0x0f)) || (padding == 1 && (c & 0x03)))
+        {
+            out.clear();
+            return false;
+        }
+        uint8_t *p = out.data() + body / 4 * 3;
+        p[0] = (uint8_t)(a << 2 | b >> 4);
+        if (padding == 1)
+        {
+            p[1] = (uint8_t)(b << 4 | c >> 2);
+        }
+    }
+    return true;
+}
+
+const char *text_codec_level()
+{
+    return dispatch().level;
+}
@@ -0,0 +1,58 @@
+#include <QFile>
+#include <QResource>
+#include <QCoreApplication>
+
+#include "etc/startup_timer.h"
+#include "etc/theme_loader.h"
+
+const std::vector<std::pair<std::string, std::string>> ThemeLoader::__supported_theme__ = {
+    {"默认", ""},
+    {"扁平白", "flatwhite"},
+    {"扁平黑", "flatblack"},
+    {"黑色", "black"},
+    {"深黑", "darkblack"},
+    {"浅黑", "lightblack"},
+    {"PS黑", "psblack"},
+    {"蓝色", "blue"},
+    {"深蓝", "darkblue"},
+    {"浅蓝", "lightblue"},
+    {"灰色", "gray"},
+    {"深灰", "darkgray"},
+    {"浅灰", "lightgray"},
+    {"银色", "silvery"},
+    {"BF", "bf"}
+};
+
+bool ThemeLoader::register_resource(QString &message)
+{
+    static bool registered = false;
+    if (registered)
+    {
+        return true;
+    }
+    QString rcc_path = QCoreApplication::applicationDirPath() + "/qss.rcc";
+    if (!QResource::registerResource(rcc_path))
+    {
+        message = "无法加载主题资源：" + rcc_path;
+        return false;
+    }
+    registered = true;
+    StartupTimer::mark("theme resource");
+    return true;
+}
+
+bool ThemeLoader::load(const QString &name, QString &style_sheet, QString &message)
+{
+    if (!register_resource(message))
+    {
+        return false;
+    }
+    QFile file(":/qss/" + name + ".css");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        message = "找不到主题：" + name;
+        return false;
+    }
+    style_sheet = QString::fromUtf8(file.readAll());
+    return true;
+}
@@ -0,0 +1,356 @@
+#include <new>
+#include <thread>
+#include <fstream>
+#include <algorithm>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cerrno>
+#endif
+
+#include "io/file_reader.h"
+#include "io/uring_queue.h"
+
+RateLimiter::RateLimiter(uint64_t bytes_per_second)
+    : m_rate(bytes_per_second), m_tokens(0), m_last(std::chrono::steady_clock::now())
+{
+}
+
+uint64_t RateLimiter::rate() const
+{
+    return m_rate;
+}
+
+void RateLimiter::set_rate(uint64_t bytes_per_second)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_rate = bytes_per_second;
+    m_tokens = std::min<double>(m_tokens, (double)bytes_per_second);
+}
+
+bool RateLimiter::acquire(size_t bytes, const std::function<bool()> &cancelled)
+{
+    if (!m_rate)
+    {
+        return true;
+    }
+    std::chrono::duration<double> wait(0);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // 可能在检查之后被改为不限速
+        const uint64_t rate = m_rate;
+        if (!rate)
+        {
+            return true;
+        }
+        auto now = std::chrono::steady_clock::now();
+        // 桶容量为一秒的流量，空闲期间攒下的令牌不会无限累积
+        m_tokens = std::min<double>((double)rate,
+                                    m_tokens + std::chrono::duration<double>(now - m_last).count() * rate);
+        m_last = now;
+        m_tokens -= (double)bytes;
+        if (m_tokens < 0)
+        {
+            wait = std::chrono::duration<double>(-m_tokens / rate);
+        }
+    }
+    // 令牌已预先扣除，睡眠期间其他读取器会继续排在后面。分段睡眠以便及时响应取消
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::nanoseconds>(wait);
+    for (auto now = std::chrono::steady_clock::now(); now < deadline; now = std::chrono::steady_clock::now())
+    {
+        if (cancelled && cancelled())
+        {
+            // 退还没有等完的令牌，避免拖慢共享该限速器的其他读取器
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tokens += std::chrono::duration<double>(deadline - now).count() * m_rate;
+            return false;
+        }
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(deadline - now, __cancel_check_interval__));
+    }
+    return true;
+}
+
+FileReader::FileReader(const FileReadOption &option) : m_option(option)
+{
+    m_option.block_size = std::max<size_t>(m_option.block_size, __direct_alignment__);
+    if (m_option.mode == FileReadMode::DIRECT)
+    {
+        m_option.block_size = (m_option.block_size + __direct_alignment__ - 1) / __direct_alignment__ * __direct_alignment__;
+    }
+}
+
+FileReader::~FileReader()
+{
+#ifdef __linux__
+    drop_prefetch();
+#endif
+    // 队列先于缓冲区和预读的文件释放，析构时等待在途请求完成
+    m_uring = nullptr;
+    if (m_buffer)
+    {
+        ::operator delete(m_buffer, std::align_val_t(__direct_alignment__));
+    }
+}
+
+uint8_t *FileReader::buffer()
+{
+    if (!m_buffer)
+    {
+        m_buffer = (uint8_t *)::operator new(m_option.block_size, std::align_val_t(__direct_alignment__));
+    }
+    return m_buffer;
+}
+
+void FileReader::prefetch(const std::string &file_path)
+{
+    m_prefetch_path = file_path;
+}
+
+std::string FileReader::note() const
+{
+    if (m_option.mode != FileReadMode::ASYNC)
+    {
+        return "";
+    }
+    if (m_uring_unavailable)
+    {
+        return "io_uring不可用，已改用缓冲读取";
+    }
+    if (m_uring && !m_uring->registered())
+    {
+        return "RLIMIT_MEMLOCK不足以注册读缓冲区，io_uring使用未注册的缓冲区";
+    }
+    return "";
+}
+
+FileReadStatus FileReader::read(const std::string &file_path, const FileBlockHandler &handler)
+{
+#ifdef __linux__
+    switch (m_option.mode)
+    {
+    case FileReadMode::BULK_SCAN:
+        return read_posix(file_path, false, handler);
+    case FileReadMode::DIRECT:
+        return read_posix(file_path, true, handler);
+    case FileReadMode::ASYNC:
+        return read_async(file_path, handler);
+    default:
+        break;
+    }
+#endif
+    // 其他平台不支持fadvise和O_DIRECT，统一使用缓冲读取
+    return read_buffered(file_path, handler);
+}
+
+FileReadStatus FileReader::read_buffered(const std::string &file_path, const FileBlockHandler &handler)
+{
+    std::ifstream ifs(file_path, std::ios::in | std::ios::binary);
+    if (!ifs)
+    {
+        return FileReadStatus::OPEN_FAILED;
+    }
+    uint8_t *buf = buffer();
+    for (;;)
+    {
+        ifs.read((char *)buf, m_option.block_size);
+        auto cnt = ifs.gcount();
+        if (!cnt)
+        {
+            return ifs.eof() ? FileReadStatus::OK : FileReadStatus::READ_FAILED;
+        }
+        if (m_option.rate_limiter && !m_option.rate_limiter->acquire(cnt, m_option.cancelled))
+        {
+            return FileReadStatus::CANCELLED;
+        }
+        if (!handler(buf, cnt))
+        {
+            return FileReadStatus::CANCELLED;
+        }
+    }
+}
+
+#ifdef __linux__
+FileReadStatus FileReader::read_posix(const std::string &file_path, bool direct, const FileBlockHandler &handler)
+{
+    int fd = -1;
+    if (direct)
+    {
+        fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+    }
+    // tmpfs等文件系统不支持O_DIRECT，退回到fadvise方式
+    if (fd < 0)
+    {
+        direct = false;
+        fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+    if (fd < 0)
+    {
+        return FileReadStatus::OPEN_FAILED;
+    }
+    if (!direct)
+    {
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    uint8_t *buf = buffer();
+    FileReadStatus status = FileReadStatus::OK;
+    off_t offset = 0;
+    for (;;)
+    {
+        // 读满一块，直到文件末尾
+        size_t cnt = 0;
+        while (cnt < m_option.block_size)
+        {
+            ssize_t n = ::read(fd, buf + cnt, m_option.block_size - cnt);
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            // 有的文件系统open时接受O_DIRECT，读取时才返回EINVAL，去掉该标志后按fadvise方式继续读
+            if (n < 0 && errno == EINVAL && direct)
+            {
+                int flags = ::fcntl(fd, F_GETFL);
+                if (flags >= 0 && ::fcntl(fd, F_SETFL, flags & ~O_DIRECT) == 0)
+                {
+                    direct = false;
+                    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+                    continue;
+                }
+            }
+            if (n < 0)
+            {
+                status = FileReadStatus::READ_FAILED;
+                break;
+            }
+            if (n == 0)
+            {
+                break;
+            }
+            cnt += n;
+            // O_DIRECT下短读意味着到达文件末尾，后续读取的偏移将不再对齐
+            if (direct && cnt % __direct_alignment__)
+            {
+                break;
+            }
+        }
+        if (status != FileReadStatus::OK || cnt == 0)
+        {
+            break;
+        }
+        if (m_option.rate_limiter && !m_option.rate_limiter->acquire(cnt, m_option.cancelled))
+        {
+            status = FileReadStatus::CANCELLED;
+            break;
+        }
+        if (!handler(buf, cnt))
+        {
+            status = FileReadStatus::CANCELLED;
+            break;
+        }
+        // 丢弃已经处理完的页缓存，避免把其他进程的热数据挤出去
+        if (!direct)
+        {
+            ::posix_fadvise(fd, offset, (off_t)cnt, POSIX_FADV_DONTNEED);
+        }
+        offset += (off_t)cnt;
+        if (cnt < m_option.block_size)
+        {
+            break;
+        }
+    }
+    ::close(fd);
+    return status;
+}
+
+FileReadStatus FileReader::read_async(const std::string &file_path, const FileBlockHandler &handler)
+{
+    std::string next_path;
+    next_path.swap(m_prefetch_path);
+    // 队列只创建一次，内核不支持时之后都直接使用缓冲读取
+    if (!m_uring && !m_uring_unavailable)
+    {
+        m_uring = UringQueue::create(__async_queue_depth__, __async_block_size__);
+        m_uring_unavailable = !m_uring;
+    }
+    if (!m_uring)
+    {
+        return read_buffered(file_path, handler);
+    }
+    int fd = -1;
+    uint64_t file_size = 0;
+    if (m_next_fd >= 0 && m_next_path == file_path)
+    {
+        // 上一次已经开始预读这个文件
+        fd = m_next_fd;
+        file_size = m_next_size;
+        m_next_fd = -1;
+    }
+    else
+    {
+        drop_prefetch();
+        fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return FileReadStatus::OPEN_FAILED;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            return FileReadStatus::READ_FAILED;
+        }
+        file_size = (uint64_t)st.st_size;
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    int next_fd = next_path.empty() ? -1 : ::open(next_path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat next_st;
+    if (next_fd >= 0 && ::fstat(next_fd, &next_st) != 0)
+    {
+        ::close(next_fd);
+        next_fd = -1;
+    }
+    if (next_fd >= 0)
+    {
+        ::posix_fadvise(next_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    FileReadStatus status = m_uring->read(fd, file_size, handler, m_option.rate_limiter.get(), m_option.cancelled,
+                                          next_fd, next_fd >= 0 ? (uint64_t)next_st.st_size : 0);
+    // 在途请求仍在使用fd，先丢弃队列再关闭，之后的文件使用缓冲读取
+    if (m_uring->broken())
+    {
+        m_uring = nullptr;
+        m_uring_unavailable = true;
+    }
+    ::close(fd);
+    if (next_fd >= 0)
+    {
+        // 出错或取消时队列已经放弃预读
+        if (status == FileReadStatus::OK && m_uring)
+        {
+            m_next_path = next_path;
+            m_next_fd = next_fd;
+            m_next_size = (uint64_t)next_st.st_size;
+        }
+        else
+        {
+            ::close(next_fd);
+        }
+    }
+    return status;
+}
+
+void FileReader::drop_prefetch()
+{
+    if (m_next_fd < 0)
+    {
+        return;
+    }
+    if (m_uring)
+    {
+        m_uring->discard_prefetch();
+    }
+    ::close(m_next_fd);
+    m_next_fd = -1;
+}
+#endif
@@ -0,0 +1,314 @@
+#include <filesystem>
+
+#ifdef __linux__
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#endif
+
+#include "io/folder_watcher.h"
+
+namespace
+{
+#ifdef __linux__
+    // IN_ATTRIB覆盖只修改元数据的操作，例如touch和cp -p恢复修改时间
+    constexpr uint32_t WATCH_MASK = IN_CREATE | IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM |
+                                    IN_MOVED_TO | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+#endif
+
+    std::string join_path(const std::string &dir, const std::string &name)
+    {
+        return dir.empty() ? name : dir + "/" + name;
+    }
+}
+
+FolderWatcher::FolderWatcher(const std::string &root, std::chrono::milliseconds debounce)
+    : m_root(std::filesystem::path(root).lexically_normal().string()), m_debounce(debounce)
+{
+    while (m_root.size() > 1 && m_root.back() == '/')
+    {
+        m_root.pop_back();
+    }
+#ifdef __linux__
+    // 在构造时创建，start之前调用stop也能生效
+    m_stop_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+}
+
+FolderWatcher::~FolderWatcher()
+{
+#ifdef __linux__
+    if (m_inotify_fd >= 0)
+    {
+        ::close(m_inotify_fd);
+    }
+    if (m_stop_fd >= 0)
+    {
+        ::close(m_stop_fd);
+    }
+#endif
+}
+
+const std::string &FolderWatcher::root() const
+{
+    return m_root;
+}
+
+void FolderWatcher::ignore_prefix(const std::string &prefix)
+{
+    m_ignored_prefixes.push_back(prefix);
+}
+
+bool FolderWatcher::ignored(const std::string &name) const
+{
+    for (const auto &prefix : m_ignored_prefixes)
+    {
+        if (name.compare(0, prefix.size(), prefix) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FolderWatcher::stopping() const
+{
+    return m_stopping;
+}
+
+std::string FolderWatcher::full_path(const std::string &path) const
+{
+    if (path.empty())
+    {
+        return m_root;
+    }
+    return m_root.back() == '/' ? m_root + path : m_root + "/" + path;
+}
+
+#ifdef __linux__
+bool FolderWatcher::start(std::string &message)
+{
+    m_inotify_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify_fd < 0 || m_stop_fd < 0)
+    {
+        message = std::string("无法初始化inotify：") + std::strerror(errno);
+        return false;
+    }
+    if (::inotify_add_watch(m_inotify_fd, m_root.c_str(), WATCH_MASK) < 0)
+    {
+        message = "无法监视目录：" + m_root + "，" + std::strerror(errno);
+        return false;
+    }
+    // 根目录的描述符在下面重新登记
+    m_watches.clear();
+    add_watch_recursive("", false);
+    return true;
+}
+
+void FolderWatcher::stop()
+{
+    m_stopping = true;
+    if (m_stop_fd >= 0)
+    {
+        uint64_t one = 1;
+        (void)::write(m_stop_fd, &one, sizeof(one));
+    }
+}
+
+void FolderWatcher::add_watch_recursive(const std::string &dir, bool report_existing)
+{
+    int wd = ::inotify_add_watch(m_inotify_fd, full_path(dir).c_str(), WATCH_MASK);
+    if (wd < 0)
+    {
+        // 目录已被删除，或超过了fs.inotify.max_user_watches
+        return;
+    }
+    m_watches[wd] = dir;
+    // 先加监视再遍历，新目录中在加监视之前写入的文件由遍历补上
+    std::error_code ec;
+    for (std::filesystem::directory_iterator iter(full_path(dir), ec), end; !ec && iter != end; iter.increment(ec))
+    {
+        std::string name = iter->path().filename().string();
+        if (ignored(name))
+        {
+            continue;
+        }
+        std::error_code type_ec;
+        if (iter->is_directory(type_ec) && !iter->is_symlink(type_ec))
+        {
+            add_watch_recursive(join_path(dir, name), report_existing);
+        }
+        else if (report_existing && iter->is_regular_file(type_ec))
+        {
+            m_pending[join_path(dir, name)] = std::chrono::steady_clock::now();
+        }
+    }
+}
+
+void FolderWatcher::remove_watch_recursive(const std::string &dir)
+{
+    for (auto iter = m_watches.begin(); iter != m_watches.end();)
+    {
+        const std::string &path = iter->second;
+        if (path == dir || path.compare(0, dir.size() + 1, dir + "/") == 0)
+        {
+            ::inotify_rm_watch(m_inotify_fd, iter->first);
+            iter = m_watches.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+    // 目录下尚未报告的文件也一并丢弃
+    for (auto iter = m_pending.begin(); iter != m_pending.end();)
+    {
+        if (iter->first.compare(0, dir.size() + 1, dir + "/") == 0)
+        {
+            iter = m_pending.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+void FolderWatcher::handle_events(const char *buf, size_t len)
+{
+    auto now = std::chrono::steady_clock::now();
+    for (size_t pos = 0; pos < len;)
+    {
+        const struct inotify_event *event = (const struct inotify_event *)(buf + pos);
+        pos += sizeof(struct inotify_event) + event->len;
+        if (event->mask & IN_Q_OVERFLOW)
+        {
+            m_overflow = true;
+            continue;
+        }
+        if (event->mask & IN_IGNORED)
+        {
+            m_watches.erase(event->wd);
+            continue;
+        }
+        auto watch = m_watches.find(event->wd);
+        if (watch == m_watches.end() || !event->len)
+        {
+            continue;
+        }
+        std::string name = event->name;
+        if (ignored(name))
+        {
+            continue;
+        }
+        std::string path = join_path(watch->second, name);
+        if (event->mask & IN_ISDIR)
+        {
+            if (event->mask & (IN_CREATE | IN_MOVED_TO))
+            {
+                add_watch_recursive(path, true);
+                m_removed.erase(path);
+            }
+            else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+            {
+                remove_watch_recursive(path);
+                m_removed.insert(path);
+            }
+            continue;
+        }
+        if (event->mask & (IN_CREATE | IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVED_TO))
+        {
+            m_pending[path] = now;
+            m_removed.erase(path);
+        }
+        else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+        {
+            m_pending.erase(path);
+            m_removed.insert(path);
+        }
+    }
+}
+
+bool FolderWatcher::wait_changes(std::vector<FileChange> &changes)
+{
+    changes.clear();
+    alignas(struct inotify_event) char buf[64 * 1024];
+    for (;;)
+    {
+        // 取出已经平静了debounce时间的文件
+        auto now = std::chrono::steady_clock::now();
+        auto next_deadline = std::chrono::steady_clock::time_point::max();
+        for (auto iter = m_pending.begin(); iter != m_pending.end();)
+        {
+            auto deadline = iter->second + m_debounce;
+            if (deadline <= now)
+            {
+                changes.push_back({iter->first, FileChangeKind::MODIFIED});
+                iter = m_pending.erase(iter);
+            }
+            else
+            {
+                next_deadline = std::min(next_deadline, deadline);
+                ++iter;
+            }
+        }
+        for (const auto &path : m_removed)
+        {
+            changes.push_back({path, FileChangeKind::REMOVED});
+        }
+        m_removed.clear();
+        if (m_overflow)
+        {
+            changes.push_back({"", FileChangeKind::RESCAN});
+            m_overflow = false;
+        }
+        if (!changes.empty())
+        {
+            return true;
+        }
+        int timeout = -1;
+        if (next_deadline != std::chrono::steady_clock::time_point::max())
+        {
+            timeout = (int)std::chrono::ceil<std::chrono::milliseconds>(next_deadline - now).count();
+        }
+        struct pollfd fds[2] = {{m_inotify_fd, POLLIN, 0}, {m_stop_fd, POLLIN, 0}};
+        int ret = ::poll(fds, 2, timeout);
+        if (ret < 0 && errno != EINTR)
+        {
+            return false;
+        }
+        if (fds[1].revents & POLLIN)
+        {
+            return false;
+        }
+        if (fds[0].revents & POLLIN)
+        {
+            ssize_t n;
+            while ((n = ::read(m_inotify_fd, buf, sizeof(buf))) > 0)
+            {
+                handle_events(buf, (size_t)n);
+            }
+        }
+    }
+}
+#else
+bool FolderWatcher::start(std::string &message)
+{
+    message = "监视文件夹只支持Linux";
+    return false;
+}
+
+void FolderWatcher::stop()
+{
+    m_stopping = true;
+}
+
+bool FolderWatcher::wait_changes(std::vector<FileChange> &changes)
+{
+    changes.clear();
+    return false;
+}
+#endif
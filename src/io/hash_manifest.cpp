@@ -0,0 +1,289 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include "io/hash_manifest.h"
+#include "service/field_codec.h"
+
+namespace
+{
+    constexpr const char *MANIFEST_HEADER = "ciftl-manifest 1";
+
+    // 格式：路径 大小 修改时间 算法=摘要...，以制表符分隔
+    std::string format_entry(const std::string &path, const ManifestEntry &entry)
+    {
+        std::vector<std::string> fields = {path, std::to_string(entry.size), std::to_string(entry.mtime)};
+        for (const auto &digest : entry.digests)
+        {
+            fields.push_back(digest.first + "=" + digest.second);
+        }
+        return FieldCodec::join(fields);
+    }
+
+    bool parse_entry(const std::vector<std::string> &fields, size_t offset, std::string &path, ManifestEntry &entry)
+    {
+        if (fields.size() < offset + 3 || fields[offset].empty())
+        {
+            return false;
+        }
+        path = fields[offset];
+        try
+        {
+            size_t pos;
+            entry.size = std::stoull(fields[offset + 1], &pos);
+            if (pos != fields[offset + 1].size())
+            {
+                return false;
+            }
+            entry.mtime = std::stoll(fields[offset + 2], &pos);
+            if (pos != fields[offset + 2].size())
+            {
+                return false;
+            }
+        }
+        catch (const std::exception &)
+        {
+            return false;
+        }
+        entry.digests.clear();
+        for (size_t i = offset + 3; i < fields.size(); i++)
+        {
+            size_t eq = fields[i].find('=');
+            if (eq == std::string::npos)
+            {
+                return false;
+            }
+            entry.digests.push_back({fields[i].substr(0, eq), fields[i].substr(eq + 1)});
+        }
+        return true;
+    }
+
+    // 删除path及其目录下的所有记录，目录下的记录在排序中不一定紧跟在path之后，需要单独查找
+    size_t erase_tree(std::map<std::string, ManifestEntry> &entries, const std::string &path)
+    {
+        size_t count = entries.erase(path);
+        const std::string prefix = path + "/";
+        for (auto iter = entries.lower_bound(prefix);
+             iter != entries.end() && iter->first.compare(0, prefix.size(), prefix) == 0;)
+        {
+            iter = entries.erase(iter);
+            count++;
+        }
+        return count;
+    }
+
+    bool sync_file(std::FILE *fp)
+    {
+        if (std::fflush(fp) != 0)
+        {
+            return false;
+        }
+#ifdef __linux__
+        return ::fsync(::fileno(fp)) == 0;
+#else
+        return true;
+#endif
+    }
+}
+
+HashManifest::HashManifest(const std::string &root)
+    : m_snapshot_path((std::filesystem::path(root) / __manifest_name__).string()),
+      m_journal_path(m_snapshot_path + __journal_suffix__)
+{
+}
+
+bool HashManifest::is_manifest_file(const std::string &name)
+{
+    return name.compare(0, std::strlen(__manifest_name__), __manifest_name__) == 0;
+}
+
+bool HashManifest::file_stat(const std::string &file_path, uint64_t &size, int64_t &mtime)
+{
+    std::error_code ec;
+    auto status = std::filesystem::symlink_status(file_path, ec);
+    if (ec || !std::filesystem::is_regular_file(status))
+    {
+        return false;
+    }
+    size = std::filesystem::file_size(file_path, ec);
+    if (ec)
+    {
+        return false;
+    }
+    auto time = std::filesystem::last_write_time(file_path, ec);
+    if (ec)
+    {
+        return false;
+    }
+    mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    return true;
+}
+
+bool HashManifest::load(std::string &message)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_journal_lines = 0;
+    std::string line;
+    std::ifstream snapshot(m_snapshot_path, std::ios::in | std::ios::binary);
+    if (snapshot.is_open())
+    {
+        if (!std::getline(snapshot, line) || line != MANIFEST_HEADER)
+        {
+            message = "清单格式不正确：" + m_snapshot_path;
+            return false;
+        }
+        std::vector<std::string> fields;
+        while (std::getline(snapshot, line))
+        {
+            std::string path;
+            ManifestEntry entry;
+            if (!FieldCodec::split(line, fields) || !parse_entry(fields, 0, path, entry))
+            {
+                message = "清单格式不正确：" + m_snapshot_path;
+                return false;
+            }
+            m_entries[path] = std::move(entry);
+        }
+    }
+    std::ifstream journal(m_journal_path, std::ios::in | std::ios::binary);
+    while (journal.is_open() && std::getline(journal, line))
+    {
+        // 没有换行结尾的最后一行是崩溃时写了一半的记录，立即重写快照，避免之后追加的记录接在它后面
+        if (journal.eof())
+        {
+            m_journal_lines = std::max(__min_compact_lines__, m_entries.size());
+            return compact_if_needed(message);
+        }
+        m_journal_lines++;
+        std::vector<std::string> fields;
+        std::string path;
+        ManifestEntry entry;
+        if (!FieldCodec::split(line, fields))
+        {
+            continue;
+        }
+        if (fields[0] == "+" && parse_entry(fields, 1, path, entry))
+        {
+            m_entries[path] = std::move(entry);
+        }
+        else if (fields[0] == "-" && fields.size() == 2)
+        {
+            erase_tree(m_entries, fields[1]);
+        }
+    }
+    return true;
+}
+
+bool HashManifest::append_journal(const std::string &line, std::string &message)
+{
+    std::FILE *fp = std::fopen(m_journal_path.c_str(), "ab");
+    if (!fp)
+    {
+        message = "无法写入清单日志：" + m_journal_path;
+        return false;
+    }
+    bool ok = std::fputs((line + "\n").c_str(), fp) >= 0;
+    ok = std::fclose(fp) == 0 && ok;
+    if (!ok)
+    {
+        message = "无法写入清单日志：" + m_journal_path;
+        return false;
+    }
+    m_journal_lines++;
+    return compact_if_needed(message);
+}
+
+bool HashManifest::compact_if_needed(std::string &message)
+{
+    // 重写快照的代价与条目数成正比，日志行数超过条目数时才重写，平摊到每次修改是常数
+    if (m_journal_lines < std::max(__min_compact_lines__, m_entries.size()))
+    {
+        return true;
+    }
+    std::string temp_path = m_snapshot_path + __temp_suffix__;
+    std::FILE *fp = std::fopen(temp_path.c_str(), "wb");
+    if (!fp)
+    {
+        message = "无法写入清单：" + temp_path;
+        return false;
+    }
+    bool ok = std::fputs((std::string(MANIFEST_HEADER) + "\n").c_str(), fp) >= 0;
+    for (auto iter = m_entries.begin(); ok && iter != m_entries.end(); ++iter)
+    {
+        ok = std::fputs((format_entry(iter->first, iter->second) + "\n").c_str(), fp) >= 0;
+    }
+    // 快照落盘后才能替换旧快照并清空日志
+    ok = sync_file(fp) && ok;
+    ok = std::fclose(fp) == 0 && ok;
+    std::error_code ec;
+    if (ok)
+    {
+        std::filesystem::rename(temp_path, m_snapshot_path, ec);
+    }
+    if (!ok || ec)
+    {
+        std::filesystem::remove(temp_path, ec);
+        message = "无法写入清单：" + m_snapshot_path;
+        return false;
+    }
+    std::filesystem::remove(m_journal_path, ec);
+    m_journal_lines = 0;
+    return true;
+}
+
+bool HashManifest::update(const std::string &path, const ManifestEntry &entry, std::string &message)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries[path] = entry;
+    return append_journal("+\t" + format_entry(path, entry), message);
+}
+
+bool HashManifest::remove(const std::string &path, std::string &message)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // 清单中没有的路径不必写日志
+    return !erase_tree(m_entries, path) || append_journal(FieldCodec::join({"-", path}), message);
+}
+
+bool HashManifest::compact(std::string &message)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_journal_lines)
+    {
+        return true;
+    }
+    m_journal_lines = std::max(__min_compact_lines__, m_entries.size());
+    return compact_if_needed(message);
+}
+
+bool HashManifest::up_to_date(const std::string &path, uint64_t size, int64_t mtime) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto iter = m_entries.find(path);
+    return iter != m_entries.end() && iter->second.size == size && iter->second.mtime == mtime;
+}
+
+std::vector<std::string> HashManifest::paths() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<std::string> res;
+    res.reserve(m_entries.size());
+    for (const auto &iter : m_entries)
+    {
+        res.push_back(iter.first);
+    }
+    return res;
+}
+
+size_t HashManifest::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
@@ -0,0 +1,319 @@
+#include <map>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <fstream>
+#include <algorithm>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/sysmacros.h>
+#include <linux/fs.h>
+#include <linux/fiemap.h>
+#endif
+
+#include "io/io_scheduler.h"
+
+namespace
+{
+    // 无法判断类型的设备使用的通道数
+    constexpr size_t UNKNOWN_DEVICE_LANES = 2;
+
+#ifdef __linux__
+    std::string sysfs_path(dev_t dev)
+    {
+        return "/sys/dev/block/" + std::to_string(major(dev)) + ":" + std::to_string(minor(dev));
+    }
+
+    // 分区所在的整块磁盘，同一磁盘的不同分区共用磁头，必须归入同一组
+    dev_t whole_disk(dev_t dev)
+    {
+        // 匿名设备（btrfs子卷、overlayfs、网络文件系统等）没有对应的块设备
+        if (major(dev) == 0)
+        {
+            return dev;
+        }
+        std::string base = sysfs_path(dev);
+        // 只有分区目录下有partition文件，上一级目录是整块磁盘，其dev文件内容为"主:次"
+        if (!std::ifstream(base + "/partition"))
+        {
+            return dev;
+        }
+        std::ifstream ifs(base + "/../dev");
+        unsigned disk_major, disk_minor;
+        char colon;
+        if (ifs >> disk_major >> colon >> disk_minor && colon == ':')
+        {
+            return makedev(disk_major, disk_minor);
+        }
+        return dev;
+    }
+
+    DeviceKind device_kind(dev_t dev)
+    {
+        if (major(dev) == 0)
+        {
+            return DeviceKind::UNKNOWN;
+        }
+        std::ifstream ifs(sysfs_path(dev) + "/queue/rotational");
+        int rotational;
+        if (ifs >> rotational)
+        {
+            return rotational ? DeviceKind::ROTATIONAL : DeviceKind::SOLID_STATE;
+        }
+        return DeviceKind::UNKNOWN;
+    }
+
+    // 分区在整块磁盘上的起始字节，整块磁盘本身为0
+    uint64_t partition_start(dev_t dev)
+    {
+        std::ifstream ifs(sysfs_path(dev) + "/start");
+        uint64_t sectors;
+        // sysfs中的start总是以512字节为单位
+        return ifs >> sectors ? sectors * 512 : 0;
+    }
+
+    // 文件第一个extent在所在分区上的物理偏移
+    bool physical_offset(const std::string &file_path, uint64_t &offset)
+    {
+        int fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+        // 只需要第一个extent
+        alignas(struct fiemap) uint8_t buf[sizeof(struct fiemap) + sizeof(struct fiemap_extent)] = {};
+        struct fiemap *map = (struct fiemap *)buf;
+        map->fm_start = 0;
+        map->fm_length = FIEMAP_MAX_OFFSET;
+        map->fm_extent_count = 1;
+        bool ok = ::ioctl(fd, FS_IOC_FIEMAP, map) == 0 && map->fm_mapped_extents > 0;
+        if (ok)
+        {
+            offset = map->fm_extents[0].fe_physical;
+        }
+        ::close(fd);
+        return ok;
+    }
+#endif
+}
+
+IoScheduler::IoScheduler(const std::vector<std::string> &file_paths, size_t solid_state_lanes)
+{
+#ifdef __linux__
+    struct FileLocation
+    {
+        size_t index;
+        uint64_t partition;
+        uint64_t inode;
+        uint64_t offset;
+        bool has_offset;
+    };
+    std::map<uint64_t, std::vector<FileLocation>> by_device;
+    std::vector<size_t> missing;
+    for (size_t i = 0; i < file_paths.size(); i++)
+    {
+        struct stat st;
+        if (::stat(file_paths[i].c_str(), &st) != 0)
+        {
+            missing.push_back(i);
+            continue;
+        }
+        by_device[(uint64_t)whole_disk(st.st_dev)].push_back({i, (uint64_t)st.st_dev, (uint64_t)st.st_ino, 0, false});
+    }
+    for (auto &[device, files] : by_device)
+    {
+        DeviceGroup group;
+        group.device = device;
+        group.kind = device_kind((dev_t)device);
+        group.lanes = std::min(device_lanes(group.kind, solid_state_lanes), files.size());
+        // 只有机械硬盘需要按物理位置排序，其余设备按inode排序即可
+        if (group.kind == DeviceKind::ROTATIONAL)
+        {
+            // 同一磁盘的多个分区之间按磁盘上的绝对位置比较
+            std::map<uint64_t, uint64_t> starts;
+            for (auto &file : files)
+            {
+                file.has_offset = physical_offset(file_paths[file.index], file.offset);
+                if (file.has_offset)
+                {
+                    auto iter = starts.find(file.partition);
+                    if (iter == starts.end())
+                    {
+                        iter = starts.emplace(file.partition, partition_start((dev_t)file.partition)).first;
+                    }
+                    file.offset += iter->second;
+                }
+            }
+        }
+        // 逐个文件判断：能取得物理偏移的文件按偏移排在前面，其余文件按inode排在后面
+        std::stable_sort(files.begin(), files.end(), [](const FileLocation &a, const FileLocation &b)
+                         {
+            if (a.has_offset != b.has_offset)
+            {
+                return a.has_offset;
+            }
+            if (a.has_offset)
+            {
+                return a.offset < b.offset;
+            }
+            return a.partition != b.partition ? a.partition < b.partition : a.inode < b.inode; });
+        for (const auto &file : files)
+        {
+            group.files.push_back(file.index);
+        }
+        m_groups.push_back(std::move(group));
+    }
+    // 无法访问的文件单独一组，交给调用方报告错误
+    if (!missing.empty())
+    {
+        DeviceGroup group;
+        group.files = missing;
+        m_groups.push_back(std::move(group));
+    }
+#else
+    (void)solid_state_lanes;
+    DeviceGroup group;
+    for (size_t i = 0; i < file_paths.size(); i++)
+    {
+        group.files.push_back(i);
+    }
+    if (!group.files.empty())
+    {
+        m_groups.push_back(std::move(group));
+    }
+#endif
+}
+
+size_t IoScheduler::lane_count() const
+{
+    size_t count = 0;
+    for (const auto &group : m_groups)
+    {
+        count += group.lanes;
+    }
+    return count;
+}
+
+const std::vector<DeviceGroup> &IoScheduler::groups() const
+{
+    return m_groups;
+}
+
+const DeviceGroup &IoScheduler::group_of(size_t lane) const
+{
+    for (const auto &group : m_groups)
+    {
+        if (lane < group.lanes)
+        {
+            return group;
+        }
+        lane -= group.lanes;
+    }
+    return m_groups.back();
+}
+
+size_t IoScheduler::device_lanes(DeviceKind kind, size_t solid_state_lanes)
+{
+    switch (kind)
+    {
+    case DeviceKind::ROTATIONAL:
+        return 1;
+    case DeviceKind::SOLID_STATE:
+        return std::max<size_t>(1, solid_state_lanes);
+    default:
+        return UNKNOWN_DEVICE_LANES;
+    }
+}
+
+void IoScheduler::run(const std::function<void(size_t lane, size_t index, size_t next)> &task) const
+{
+    // 同一设备的各通道从该组的队列中依次取文件，每条通道提前取走下一个文件，预读的文件不会被其他通道读取
+    std::vector<std::unique_ptr<std::atomic<size_t>>> next;
+    std::vector<std::function<void()>> lanes;
+    size_t lane = 0;
+    for (const auto &group : m_groups)
+    {
+        next.push_back(std::make_unique<std::atomic<size_t>>(0));
+        std::atomic<size_t> *group_next = next.back().get();
+        for (size_t i = 0; i < group.lanes; i++, lane++)
+        {
+            lanes.push_back([&task, &group, group_next, lane]()
+                            {
+                const size_t count = group.files.size();
+                for (size_t k = (*group_next)++; k < count;)
+                {
+                    size_t next = (*group_next)++;
+                    task(lane, group.files[k], next < count ? group.files[next] : __no_file__);
+                    k = next;
+                } });
+        }
+    }
+    if (lanes.empty())
+    {
+        return;
+    }
+    // 最后一条通道在调用线程中执行，只有一条通道时不创建线程
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i + 1 < lanes.size(); i++)
+    {
+        threads.emplace_back(lanes[i]);
+    }
+    lanes.back()();
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+}
+
+bool DeviceGate::acquire(uint64_t device, size_t lanes, bool urgent, const std::function<bool()> &cancelled)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    Device &dev = m_devices[device];
+    auto &waiters = urgent ? dev.urgent_waiters : dev.normal_waiters;
+    uint64_t ticket = m_next_ticket++;
+    waiters.push_back(ticket);
+    auto my_turn = [&]()
+    {
+        if (dev.busy >= std::max<size_t>(1, lanes))
+        {
+            return false;
+        }
+        return urgent ? dev.urgent_waiters.front() == ticket
+                      : dev.urgent_waiters.empty() && dev.normal_waiters.front() == ticket;
+    };
+    // 取消不会唤醒这里，定期检查
+    while (!m_cv.wait_for(lock, std::chrono::milliseconds(100), my_turn))
+    {
+        if (cancelled())
+        {
+            waiters.erase(std::find(waiters.begin(), waiters.end(), ticket));
+            // 排在后面的等待者可能因此轮到
+            m_cv.notify_all();
+            return false;
+        }
+    }
+    waiters.pop_front();
+    dev.busy++;
+    // 通道数大于1时后面的等待者可能也能开始
+    m_cv.notify_all();
+    return true;
+}
+
+void DeviceGate::release(uint64_t device)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Device &dev = m_devices[device];
+        dev.busy--;
+        if (!dev.busy && dev.urgent_waiters.empty() && dev.normal_waiters.empty())
+        {
+            m_devices.erase(device);
+        }
+    }
+    m_cv.notify_all();
+}
@@ -0,0 +1,440 @@
+#include <new>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define URING_QUEUE_SUPPORTED
+#include <cerrno>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#include "io/uring_queue.h"
+
+#ifdef URING_QUEUE_SUPPORTED
+
+struct UringQueue::Ring
+{
+    // 一个请求槽位，对应某个文件的一块
+    struct Slot
+    {
+        int fd = -1;
+        uint64_t block = 0;
+        size_t done = 0;
+        size_t len = 0;
+        bool ready = false;
+        bool failed = false;
+    };
+
+    int fd = -1;
+    unsigned sq_entries = 0;
+    // 提交队列
+    void *sq_ptr = MAP_FAILED;
+    size_t sq_size = 0;
+    unsigned *sq_tail = nullptr;
+    unsigned *sq_mask = nullptr;
+    unsigned *sq_array = nullptr;
+    io_uring_sqe *sqes = (io_uring_sqe *)MAP_FAILED;
+    size_t sqes_size = 0;
+    // 完成队列，内核支持时与提交队列共用一次映射
+    void *cq_ptr = MAP_FAILED;
+    size_t cq_size = 0;
+    unsigned *cq_head = nullptr;
+    unsigned *cq_tail = nullptr;
+    unsigned *cq_mask = nullptr;
+    io_uring_cqe *cqes = nullptr;
+    // 读缓冲区，每个请求槽位一块
+    uint8_t *buffer = nullptr;
+    bool registered = false;
+    // 未注册缓冲区时READV使用的iovec，请求完成前必须保持有效
+    std::vector<iovec> iovecs;
+    std::vector<Slot> slots;
+    size_t block_size = 0;
+    size_t depth = 0;
+    unsigned to_submit = 0;
+    size_t inflight = 0;
+    // 下一个文件的第0块使用的槽位
+    size_t next_slot = 0;
+    // 预读的文件及已经提交的块数
+    int prefetch_fd = -1;
+    uint64_t prefetch_submitted = 0;
+    // io_uring_enter失败时可能仍有读请求在途，内核随时会写入缓冲区
+    bool broken = false;
+
+    ~Ring()
+    {
+        if (sqes != MAP_FAILED)
+        {
+            ::munmap(sqes, sqes_size);
+        }
+        if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr)
+        {
+            ::munmap(cq_ptr, cq_size);
+        }
+        if (sq_ptr != MAP_FAILED)
+        {
+            ::munmap(sq_ptr, sq_size);
+        }
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        // 关闭fd后内核异步回收在途请求，损坏的队列不释放缓冲区，避免被复用的内存遭到写入
+        if (buffer && !broken)
+        {
+            ::operator delete(buffer, std::align_val_t(FileReader::__direct_alignment__));
+        }
+    }
+
+    uint8_t *slot_buffer(size_t slot)
+    {
+        return buffer + slot * block_size;
+    }
+
+    // 在槽位index上为文件file_fd的第block块提交读请求
+    void start_block(size_t index, int file_fd, uint64_t block, uint64_t file_size)
+    {
+        slots[index] = {file_fd, block, 0, (size_t)std::min<uint64_t>(block_size, file_size - block * block_size),
+                        false, false};
+        prepare_read(index);
+    }
+
+    // 提交槽位index剩余部分的读请求
+    void prepare_read(size_t index)
+    {
+        const Slot &slot = slots[index];
+        unsigned tail = *sq_tail;
+        unsigned sq_index = tail & *sq_mask;
+        io_uring_sqe *sqe = &sqes[sq_index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->fd = slot.fd;
+        sqe->off = slot.block * block_size + slot.done;
+        if (registered)
+        {
+            sqe->opcode = IORING_OP_READ_FIXED;
+            sqe->addr = (uint64_t)(uintptr_t)(slot_buffer(index) + slot.done);
+            sqe->len = (uint32_t)(slot.len - slot.done);
+            sqe->buf_index = (uint16_t)index;
+        }
+        else
+        {
+            iovecs[index].iov_base = slot_buffer(index) + slot.done;
+            iovecs[index].iov_len = slot.len - slot.done;
+            sqe->opcode = IORING_OP_READV;
+            sqe->addr = (uint64_t)(uintptr_t)&iovecs[index];
+            sqe->len = 1;
+        }
+        sqe->user_data = index;
+        sq_array[sq_index] = sq_index;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+        to_submit++;
+        inflight++;
+    }
+
+    // 提交所有请求并至少等待一个完成
+    bool submit_and_wait()
+    {
+        for (;;)
+        {
+            int ret = (int)::syscall(__NR_io_uring_enter, fd, to_submit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (ret >= 0)
+            {
+                to_submit -= std::min<unsigned>(to_submit, (unsigned)ret);
+                return true;
+            }
+            if (errno != EINTR)
+            {
+                return false;
+            }
+        }
+    }
+
+    // 处理所有已到达的完成事件，短读和可重试的错误重新提交，其余错误标记在槽位上
+    void reap()
+    {
+        for (;;)
+        {
+            unsigned head = *cq_head;
+            if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+            {
+                return;
+            }
+            io_uring_cqe *cqe = &cqes[head & *cq_mask];
+            size_t index = (size_t)cqe->user_data;
+            int res = cqe->res;
+            __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+            inflight--;
+            Slot &slot = slots[index];
+            if (res == -EAGAIN || res == -EINTR)
+            {
+                prepare_read(index);
+                continue;
+            }
+            if (res <= 0)
+            {
+                // 出错或文件被截断
+                slot.failed = true;
+                slot.ready = true;
+                continue;
+            }
+            slot.done += res;
+            if (slot.done < slot.len)
+            {
+                // 短读，继续读取剩余部分
+                prepare_read(index);
+                continue;
+            }
+            slot.ready = true;
+        }
+    }
+
+    // 等待所有在途请求（包括期间重新提交的短读）完成，结果全部丢弃
+    bool drain()
+    {
+        while (inflight)
+        {
+            if (!submit_and_wait())
+            {
+                broken = true;
+                return false;
+            }
+            reap();
+        }
+        return true;
+    }
+};
+
+std::unique_ptr<UringQueue> UringQueue::create(size_t queue_depth, size_t block_size)
+{
+    auto ring = std::make_unique<Ring>();
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ring->fd = (int)::syscall(__NR_io_uring_setup, (unsigned)queue_depth, &params);
+    if (ring->fd < 0)
+    {
+        return nullptr;
+    }
+    ring->sq_entries = params.sq_entries;
+    ring->depth = std::min<size_t>(queue_depth, params.sq_entries);
+    ring->block_size = block_size;
+    // 映射提交队列、完成队列和SQE数组
+    ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap)
+    {
+        ring->sq_size = ring->cq_size = std::max(ring->sq_size, ring->cq_size);
+    }
+    ring->sq_ptr = ::mmap(nullptr, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    ring->cq_ptr = single_mmap ? ring->sq_ptr
+                               : ::mmap(nullptr, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                        ring->fd, IORING_OFF_CQ_RING);
+    if (ring->cq_ptr == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    ring->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    ring->sqes = (io_uring_sqe *)::mmap(nullptr, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                        ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    uint8_t *sq = (uint8_t *)ring->sq_ptr, *cq = (uint8_t *)ring->cq_ptr;
+    ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (io_uring_cqe *)(cq + params.cq_off.cqes);
+    ring->buffer = (uint8_t *)::operator new(ring->depth * block_size, std::align_val_t(FileReader::__direct_alignment__));
+    ring->slots.resize(ring->depth);
+    ring->iovecs.resize(ring->depth);
+    for (size_t i = 0; i < ring->depth; i++)
+    {
+        ring->iovecs[i].iov_base = ring->slot_buffer(i);
+        ring->iovecs[i].iov_len = block_size;
+    }
+    // 注册的缓冲区计入RLIMIT_MEMLOCK（普通用户默认只有8 MiB，同一用户的其他队列也占用这个额度），
+    // 注册失败时改用READV，每次请求多一次页表查找，仍然保持同样的队列深度
+    ring->registered = ::syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS, ring->iovecs.data(),
+                                 (unsigned)ring->depth) == 0;
+    std::unique_ptr<UringQueue> queue(new UringQueue());
+    queue->m_ring = std::move(ring);
+    return queue;
+}
+
+UringQueue::~UringQueue()
+{
+    // 未注册的缓冲区不受内核保护，释放前必须等待在途请求完成
+    if (m_ring && !m_ring->broken)
+    {
+        m_ring->drain();
+    }
+}
+
+bool UringQueue::broken() const
+{
+    return m_ring->broken;
+}
+
+bool UringQueue::registered() const
+{
+    return m_ring->registered;
+}
+
+void UringQueue::discard_prefetch()
+{
+    Ring &ring = *m_ring;
+    if (ring.prefetch_fd < 0)
+    {
+        return;
+    }
+    ring.drain();
+    ring.prefetch_fd = -1;
+    ring.prefetch_submitted = 0;
+}
+
+FileReadStatus UringQueue::read(int fd, uint64_t file_size, const FileBlockHandler &handler, RateLimiter *rate_limiter,
+                                const std::function<bool()> &cancelled, int next_fd, uint64_t next_size)
+{
+    Ring &ring = *m_ring;
+    const uint64_t block_size = ring.block_size;
+    const size_t depth = ring.depth;
+    // 第b块使用槽位(base + b) % depth，按顺序交付后槽位才会被后面的块复用
+    uint64_t submitted = 0, delivered = 0;
+    if (ring.prefetch_fd == fd)
+    {
+        submitted = ring.prefetch_submitted;
+    }
+    else
+    {
+        discard_prefetch();
+    }
+    ring.prefetch_fd = -1;
+    ring.prefetch_submitted = 0;
+    const size_t base = ring.next_slot;
+    const uint64_t block_count = (file_size + block_size - 1) / block_size;
+    const size_t next_base = (size_t)((base + block_count) % depth);
+    const uint64_t next_count = next_fd >= 0 ? (next_size + block_size - 1) / block_size : 0;
+    uint64_t next_submitted = 0;
+    FileReadStatus status = FileReadStatus::OK;
+    while (delivered < block_count)
+    {
+        // 填满队列
+        while (status == FileReadStatus::OK && submitted < block_count && submitted - delivered < depth)
+        {
+            ring.start_block((size_t)((base + submitted) % depth), fd, submitted, file_size);
+            submitted++;
+        }
+        // 当前文件的请求都已提交，剩余的槽位预读下一个文件
+        while (status == FileReadStatus::OK && submitted == block_count && next_submitted < next_count &&
+               block_count - delivered + next_submitted < depth)
+        {
+            ring.start_block((size_t)((next_base + next_submitted) % depth), next_fd, next_submitted, next_size);
+            next_submitted++;
+        }
+        // 按文件偏移顺序交付已完成的块，预读的块在上一个文件读取期间就可能已经完成
+        const uint64_t delivered_before = delivered;
+        while (status == FileReadStatus::OK && delivered < submitted)
+        {
+            size_t index = (size_t)((base + delivered) % depth);
+            Ring::Slot &slot = ring.slots[index];
+            if (!slot.ready)
+            {
+                break;
+            }
+            if (slot.failed)
+            {
+                status = FileReadStatus::READ_FAILED;
+                break;
+            }
+            if ((rate_limiter && !rate_limiter->acquire(slot.len, cancelled)) ||
+                !handler(ring.slot_buffer(index), slot.len))
+            {
+                status = FileReadStatus::CANCELLED;
+                break;
+            }
+            slot.ready = false;
+            delivered++;
+        }
+        if (status != FileReadStatus::OK)
+        {
+            break;
+        }
+        // 交付后空出了槽位，先补充请求再等待
+        if (delivered != delivered_before)
+        {
+            continue;
+        }
+        if (!ring.inflight)
+        {
+            break;
+        }
+        if (!ring.submit_and_wait())
+        {
+            // 无法再等待完成事件，缓冲区可能仍被内核占用，队列不能再用于下一个文件
+            ring.broken = true;
+            return FileReadStatus::READ_FAILED;
+        }
+        ring.reap();
+    }
+    ring.next_slot = next_base;
+    if (status != FileReadStatus::OK)
+    {
+        // 出错或取消时连同预读一起等待在途请求完成，下一个文件从头读取
+        ring.drain();
+        return status;
+    }
+    if (next_fd >= 0)
+    {
+        ring.prefetch_fd = next_fd;
+        ring.prefetch_submitted = next_submitted;
+    }
+    return status;
+}
+
+#else
+
+struct UringQueue::Ring
+{
+};
+
+std::unique_ptr<UringQueue> UringQueue::create(size_t, size_t)
+{
+    return nullptr;
+}
+
+UringQueue::~UringQueue() = default;
+
+bool UringQueue::broken() const
+{
+    return true;
+}
+
+bool UringQueue::registered() const
+{
+    return false;
+}
+
+void UringQueue::discard_prefetch()
+{
+}
+
+FileReadStatus UringQueue::read(int, uint64_t, const FileBlockHandler &, RateLimiter *, const std::function<bool()> &,
+                                int, uint64_t)
+{
+    return FileReadStatus::READ_FAILED;
+}
+
+#endif
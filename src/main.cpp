@@ -1,12 +1,22 @@
 #include "mainwindow.h"
+#include "etc/startup_timer.h"
+#include "service/hash_command.h"
 
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
+    // 守护进程和命令行校验不创建窗口
+    if (argc > 1 && HashCommand::is_command(argv[1]))
+    {
+        return HashCommand::run(argc, argv);
+    }
+    StartupTimer::start();
     std::srand((unsigned int)std::time(NULL));
     QApplication a(argc, argv);
+    StartupTimer::mark("application");
     MainWindow w;
+    StartupTimer::mark("main window");
     w.show();
     return a.exec();
 }
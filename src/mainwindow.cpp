@@ -1,16 +1,22 @@
+#include <QTimer>
 #include <QVBoxLayout>
 #include <QMessageBox>
+#include <QActionGroup>
 
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 
 #include "cryption/hash_form.h"
 #include "cryption/crypter_form.h"
+#include "etc/startup_timer.h"
+#include "etc/theme_loader.h"
 
 MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent), ui(new Ui::MainWindow), m_hash_form(new HashForm(this)), m_crypter_form(new CrypterForm(this))
+    : QMainWindow(parent), ui(new Ui::MainWindow)
 {
     ui->setupUi(this);
+    m_default_style_sheet = styleSheet();
+    StartupTimer::mark("main window ui");
 
     static const char *help_info =
         "ciftl是一个密码学工具箱\n"
@@ -19,16 +25,13 @@ MainWindow::MainWindow(QWidget *parent)
         "哈希工具：用于对文件进行哈希计算，支持MD5, Sha1, Sha256, Sha512四种哈希算法\n"
         "作者：三点一洲（sandinpool）\n"
         "Copyright (c) 三点一洲（sandinpool） All copyright reserved";
-    ui->stackedWidget->addWidget(m_crypter_form);
-    ui->stackedWidget->addWidget(m_hash_form);
-
     connect(ui->actionCrypter, &QAction::triggered, this, [this]()
             {
-        ui->stackedWidget->setCurrentWidget(m_crypter_form);
+        ui->stackedWidget->setCurrentWidget(crypter_form());
         ui->statusbar->showMessage("密码工具"); });
     connect(ui->actionHash, &QAction::triggered, this, [this]()
             {
-        ui->stackedWidget->setCurrentWidget(m_hash_form);
+        ui->stackedWidget->setCurrentWidget(hash_form());
         ui->statusbar->showMessage("哈希工具"); });
     connect(ui->actionAbout, &QAction::triggered,
             this, [this]
@@ -43,9 +46,67 @@ MainWindow::~MainWindow()
 void MainWindow::show()
 {
     QMainWindow::show();
-    // 默认显示
-    ui->stackedWidget->setCurrentWidget(m_crypter_form);
     ui->statusbar->showMessage("ciftl");
+    StartupTimer::mark("main window shown");
+    // 窗口先显示出来，默认页在事件循环开始后再创建
+    QTimer::singleShot(0, this, [this]()
+                       {
+        if (!ui->stackedWidget->currentWidget())
+        {
+            ui->stackedWidget->setCurrentWidget(crypter_form());
+        }
+        load_theme_menu();
+        StartupTimer::mark("event loop started"); });
+}
+
+CrypterForm *MainWindow::crypter_form()
+{
+    if (!m_crypter_form)
+    {
+        m_crypter_form = new CrypterForm(this);
+        ui->stackedWidget->addWidget(m_crypter_form);
+        StartupTimer::mark("crypter form");
+    }
+    return m_crypter_form;
+}
+
+HashForm *MainWindow::hash_form()
+{
+    if (!m_hash_form)
+    {
+        m_hash_form = new HashForm(this);
+        ui->stackedWidget->addWidget(m_hash_form);
+        StartupTimer::mark("hash form");
+    }
+    return m_hash_form;
+}
+
+void MainWindow::load_theme_menu()
+{
+    // 菜单项只记录主题名，选择时才加载主题资源
+    QActionGroup *group = new QActionGroup(this);
+    for (const auto &iter : ThemeLoader::__supported_theme__)
+    {
+        QAction *action = ui->menuTheme->addAction(QString::fromStdString(iter.first));
+        action->setCheckable(true);
+        action->setChecked(iter.second.empty());
+        group->addAction(action);
+        QString name = QString::fromStdString(iter.second);
+        connect(action, &QAction::triggered, this, [this, name]()
+                {
+            if (name.isEmpty())
+            {
+                setStyleSheet(m_default_style_sheet);
+                return;
+            }
+            QString style_sheet, message;
+            if (!ThemeLoader::load(name, style_sheet, message))
+            {
+                QMessageBox::warning(this, "主题", message);
+                return;
+            }
+            setStyleSheet(style_sheet); });
+    }
 }
 
 void MainWindow::set_status_message(const QString &mes)
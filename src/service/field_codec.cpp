@@ -0,0 +1,74 @@
+#include "service/field_codec.h"
+
+std::string FieldCodec::join(const std::vector<std::string> &fields)
+{
+    std::string line;
+    for (size_t i = 0; i < fields.size(); i++)
+    {
+        if (i)
+        {
+            line += '\t';
+        }
+        for (char c : fields[i])
+        {
+            switch (c)
+            {
+            case '\\':
+                line += "\\\\";
+                break;
+            case '\t':
+                line += "\\t";
+                break;
+            case '\n':
+                line += "\\n";
+                break;
+            case '\r':
+                line += "\\r";
+                break;
+            default:
+                line += c;
+            }
+        }
+    }
+    return line;
+}
+
+bool FieldCodec::split(std::string_view line, std::vector<std::string> &fields)
+{
+    fields.assign(1, std::string());
+    for (size_t i = 0; i < line.size(); i++)
+    {
+        if (line[i] == '\t')
+        {
+            fields.emplace_back();
+            continue;
+        }
+        if (line[i] != '\\')
+        {
+            fields.back() += line[i];
+            continue;
+        }
+        if (++i == line.size())
+        {
+            return false;
+        }
+        switch (line[i])
+        {
+        case '\\':
+            fields.back() += '\\';
+            break;
+        case 't':
+            fields.back() += '\t';
+            break;
+        case 'n':
+            fields.back() += '\n';
+            break;
+        case 'r':
+            fields.back() += '\r';
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
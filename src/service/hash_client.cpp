@@ -0,0 +1,99 @@
+#include <filesystem>
+
+#include "service/hash_client.h"
+#include "service/hash_protocol.h"
+
+bool HashClient::connect(const std::string &socket_path, std::string &message)
+{
+    // 守护进程没有运行时套接字文件不存在，只检查文件即可，不必每次都尝试连接
+    std::error_code ec;
+    if (!std::filesystem::is_socket(socket_path, ec))
+    {
+        message = "守护进程没有运行";
+        return false;
+    }
+    if (!m_socket.connect(socket_path, message))
+    {
+        return false;
+    }
+    // 套接字可能由其他用户抢先监听，确认对端进程属于当前用户后才发送文件路径
+    if (!m_socket.same_user())
+    {
+        m_socket.shutdown();
+        message = "守护进程不属于当前用户：" + socket_path;
+        return false;
+    }
+    return true;
+}
+
+bool HashClient::hash(const HashRequest &request, const HashCallback &callback, const std::function<bool()> &cancelled,
+                      std::string &message)
+{
+    // 守护进程的工作目录与客户端不同，发送绝对路径
+    HashRequest absolute_request = request;
+    for (auto &path : absolute_request.file_paths)
+    {
+        std::error_code ec;
+        auto absolute_path = std::filesystem::absolute(path, ec);
+        if (!ec)
+        {
+            path = absolute_path.string();
+        }
+    }
+    if (!m_socket.send_line(HashProtocol::encode_request(absolute_request)))
+    {
+        message = "无法发送请求";
+        return false;
+    }
+    for (;;)
+    {
+        if (cancelled())
+        {
+            // 析构时关闭连接
+            m_socket.shutdown();
+            message = "已取消";
+            return false;
+        }
+        std::string line;
+        bool timed_out;
+        if (!m_socket.read_line(line, 100, timed_out, HashProtocol::__max_line_size__))
+        {
+            if (timed_out)
+            {
+                continue;
+            }
+            message = "与守护进程的连接已断开";
+            return false;
+        }
+        HashReplyKind kind;
+        size_t percent = 0;
+        HashResult result;
+        if (!HashProtocol::decode_reply(line, kind, percent, result, message))
+        {
+            message = "守护进程的回复格式不正确";
+            return false;
+        }
+        if (kind == HashReplyKind::END)
+        {
+            return true;
+        }
+        if (kind == HashReplyKind::FAILED)
+        {
+            return false;
+        }
+        if (kind == HashReplyKind::PROGRESS)
+        {
+            callback.on_progress(percent);
+        }
+        else
+        {
+            // 调用方用序号直接索引文件列表，超出范围的结果不能交给它
+            if (result.index >= request.file_paths.size())
+            {
+                message = "守护进程回复的文件序号超出范围";
+                return false;
+            }
+            callback.on_result(result);
+        }
+    }
+}
@@ -0,0 +1,182 @@
+#include <future>
+#include <thread>
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+#include <csignal>
+#include <pthread.h>
+#endif
+
+#include "service/hash_client.h"
+#include "service/hash_daemon.h"
+#include "service/hash_command.h"
+
+namespace
+{
+    const char *USAGE = "用法：\n"
+                        "  ciftl-gui --daemon [--socket 路径]\n"
+                        "  ciftl-gui --hash [--algorithm MD5,Sha1,Sha256,Sha512] [--socket 路径] [--local] 文件...\n";
+
+    std::vector<std::string> split_names(const std::string &str)
+    {
+        std::vector<std::string> names;
+        size_t start = 0;
+        for (size_t pos; (pos = str.find(',', start)) != std::string::npos; start = pos + 1)
+        {
+            names.push_back(str.substr(start, pos - start));
+        }
+        names.push_back(str.substr(start));
+        return names;
+    }
+
+    const char *status_message(FileReadStatus status)
+    {
+        switch (status)
+        {
+        case FileReadStatus::OPEN_FAILED:
+            return "无法打开文件";
+        case FileReadStatus::READ_FAILED:
+            return "读取文件失败";
+        case FileReadStatus::CANCELLED:
+            return "已取消";
+        default:
+            return "";
+        }
+    }
+}
+
+bool HashCommand::is_command(const char *arg)
+{
+    return std::strcmp(arg, "--daemon") == 0 || std::strcmp(arg, "--hash") == 0;
+}
+
+int HashCommand::run(int argc, char *argv[])
+{
+    bool daemon = std::strcmp(argv[1], "--daemon") == 0;
+    bool local = false;
+    std::string socket_path = HashDaemon::default_socket_path();
+    std::vector<std::string> hasher_names = {__default_algorithm__};
+    std::vector<std::string> file_paths;
+    for (int i = 2; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc)
+        {
+            socket_path = argv[++i];
+        }
+        else if (arg == "--algorithm" && i + 1 < argc && !daemon)
+        {
+            hasher_names = split_names(argv[++i]);
+        }
+        else if (arg == "--local" && !daemon)
+        {
+            local = true;
+        }
+        else if (!daemon && (arg.empty() || arg[0] != '-'))
+        {
+            file_paths.push_back(arg);
+        }
+        else
+        {
+            std::cerr << USAGE;
+            return 2;
+        }
+    }
+    if (daemon)
+    {
+        return run_daemon(socket_path);
+    }
+    for (const auto &name : hasher_names)
+    {
+        if (HashEngine::generate_hasher_vec({name}).empty())
+        {
+            std::cerr << "不支持的哈希算法：" << name << "\n";
+            return 2;
+        }
+    }
+    if (file_paths.empty())
+    {
+        std::cerr << USAGE;
+        return 2;
+    }
+    return run_hash(socket_path, local, hasher_names, file_paths);
+}
+
+int HashCommand::run_daemon(const std::string &socket_path)
+{
+#ifdef __linux__
+    // 在创建任何线程之前屏蔽，信号只由主线程的sigwait接收
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    HashDaemon daemon(socket_path);
+    std::string message;
+    if (!daemon.start(message))
+    {
+        std::cerr << message << "\n";
+        return 1;
+    }
+    std::cerr << "守护进程已启动：" << socket_path << "\n";
+    std::thread runner([&]()
+                       { daemon.run(); });
+    int sig;
+    sigwait(&signals, &sig);
+    daemon.stop();
+    runner.join();
+    return 0;
+#else
+    std::cerr << "守护进程只支持Linux\n";
+    return 1;
+#endif
+}
+
+int HashCommand::run_hash(const std::string &socket_path, bool local, const std::vector<std::string> &hasher_names,
+                          const std::vector<std::string> &file_paths)
+{
+    HashRequest request;
+    request.file_paths = file_paths;
+    request.hasher_names = hasher_names;
+    bool failed = false;
+    HashCallback callback;
+    callback.on_progress = [](size_t) {};
+    callback.on_result = [&](const HashResult &result)
+    {
+        const std::string &file_path = file_paths[result.index];
+        if (result.status != FileReadStatus::OK)
+        {
+            std::cerr << file_path << ": " << status_message(result.status) << "\n";
+            failed = true;
+            return;
+        }
+        for (const auto &digest : result.digests)
+        {
+            std::cout << digest.first << " (" << file_path << ") = " << digest.second << "\n";
+        }
+    };
+    std::string message;
+    HashClient client;
+    if (!local && client.connect(socket_path, message))
+    {
+        if (!client.hash(request, callback, []()
+                         { return false; }, message))
+        {
+            std::cerr << message << "\n";
+            return 1;
+        }
+        return failed ? 1 : 0;
+    }
+    // 守护进程没有运行，在本进程中计算
+    HashEngine engine(1);
+    std::promise<void> ended;
+    callback.on_end = [&]()
+    {
+        ended.set_value();
+    };
+    engine.submit(request, callback);
+    ended.get_future().wait();
+    return failed ? 1 : 0;
+}
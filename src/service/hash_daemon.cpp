@@ -0,0 +1,214 @@
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <filesystem>
+#include <condition_variable>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+#endif
+
+#include "service/hash_daemon.h"
+#include "service/hash_protocol.h"
+
+HashDaemon::HashDaemon(const std::string &socket_path, size_t worker_count)
+    : m_socket_path(socket_path), m_engine(worker_count)
+{
+#ifdef __linux__
+    m_stop_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+}
+
+HashDaemon::~HashDaemon()
+{
+#ifdef __linux__
+    if (m_stop_fd >= 0)
+    {
+        ::close(m_stop_fd);
+    }
+#endif
+}
+
+std::string HashDaemon::default_socket_path()
+{
+    const char *runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir && *runtime_dir)
+    {
+        return std::string(runtime_dir) + "/ciftl-gui.sock";
+    }
+#ifdef __linux__
+    return fallback_socket_dir() + "/ciftl-gui.sock";
+#else
+    return "";
+#endif
+}
+
+std::string HashDaemon::fallback_socket_dir()
+{
+#ifdef __linux__
+    return "/tmp/ciftl-gui-" + std::to_string(::geteuid());
+#else
+    return "";
+#endif
+}
+
+bool HashDaemon::prepare_socket_dir(const std::string &dir, std::string &message)
+{
+#ifdef __linux__
+    // /tmp所有用户都可以写，其他用户可能抢先建立同名目录或符号链接，已经存在时检查属主和权限
+    if (::mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST)
+    {
+        message = "无法建立套接字目录：" + dir;
+        return false;
+    }
+    struct stat st;
+    if (::lstat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode) || st.st_uid != ::geteuid() ||
+        (st.st_mode & 0077) != 0)
+    {
+        message = "套接字目录不属于当前用户或其他用户可以访问：" + dir;
+        return false;
+    }
+    return true;
+#else
+    message = "当前平台不支持";
+    return false;
+#endif
+}
+
+bool HashDaemon::start(std::string &message)
+{
+    // 只有/tmp下的默认目录需要自己建立，$XDG_RUNTIME_DIR和用户指定的路径由其自行负责
+    if (!m_socket_path.empty() &&
+        std::filesystem::path(m_socket_path).parent_path() == std::filesystem::path(fallback_socket_dir()) &&
+        !prepare_socket_dir(fallback_socket_dir(), message))
+    {
+        return false;
+    }
+    return m_listener.listen(m_socket_path, message);
+}
+
+void HashDaemon::stop()
+{
+#ifdef __linux__
+    uint64_t one = 1;
+    (void)::write(m_stop_fd, &one, sizeof(one));
+#endif
+}
+
+void HashDaemon::run()
+{
+    for (int fd; (fd = m_listener.accept(m_stop_fd)) >= 0;)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // 回收已经结束的连接线程
+        for (size_t id : m_finished)
+        {
+            m_clients[id].first.join();
+            m_clients.erase(id);
+        }
+        m_finished.clear();
+        size_t id = m_next_client++;
+        auto client = std::make_shared<UnixSocket>(fd);
+        m_clients[id] = {std::thread([this, id, client]()
+                                     {
+            serve(*client);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_finished.push_back(id); }),
+                         client};
+    }
+    // 取消所有请求并断开所有连接，连接线程随即结束
+    m_engine.cancel_all();
+    std::map<size_t, std::pair<std::thread, std::shared_ptr<UnixSocket>>> clients;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        clients.swap(m_clients);
+    }
+    for (auto &iter : clients)
+    {
+        iter.second.second->shutdown();
+    }
+    for (auto &iter : clients)
+    {
+        iter.second.first.join();
+    }
+#ifdef __linux__
+    ::unlink(m_socket_path.c_str());
+#endif
+}
+
+void HashDaemon::serve(UnixSocket &client)
+{
+    if (!client.same_user())
+    {
+        client.send_line(HashProtocol::encode_error("只接受同一用户的连接"));
+        return;
+    }
+    std::string line;
+    bool timed_out;
+    // 请求在连接后立即发送，长时间没有请求的连接直接关闭
+    if (!client.read_line(line, 10000, timed_out, HashProtocol::__max_line_size__))
+    {
+        return;
+    }
+    HashRequest request;
+    if (!HashProtocol::decode_request(line, request))
+    {
+        client.send_line(HashProtocol::encode_error("请求格式不正确"));
+        return;
+    }
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool ended = false;
+    std::atomic<bool> broken = false;
+    size_t last_percent = 101;
+    // 同一请求的回调不会同时进入，回调中发送的内容不会交错
+    HashCallback callback;
+    callback.on_progress = [&](size_t percent)
+    {
+        // 只在百分比变化时发送
+        if (percent != last_percent)
+        {
+            last_percent = percent;
+            broken = broken || !client.send_line(HashProtocol::encode_progress(percent));
+        }
+    };
+    callback.on_result = [&](const HashResult &result)
+    {
+        last_percent = 101;
+        broken = broken || !client.send_line(HashProtocol::encode_result(result));
+    };
+    callback.on_end = [&]()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ended = true;
+        cv.notify_all();
+    };
+    auto control = m_engine.submit(request, callback);
+    // 客户端在请求结束前不再发送数据，可读说明连接已关闭
+    for (;;)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (ended)
+            {
+                break;
+            }
+        }
+        std::string extra;
+        if (broken || (!client.read_line(extra, 100, timed_out, 0) && !timed_out))
+        {
+            control->cancel();
+            break;
+        }
+    }
+    // 回调引用了本函数的局部变量，必须等任务结束
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&]()
+            { return ended; });
+    if (!broken)
+    {
+        client.send_line(HashProtocol::encode_end());
+    }
+}
@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <filesystem>
+
+#include "etc/text_codec.h"
+#include "io/hash_manifest.h"
+#include "service/hash_engine.h"
+
+HashEngine::HashEngine(size_t worker_count, size_t cache_capacity)
+    : m_cache_capacity(std::max<size_t>(1, cache_capacity)), m_rate_limiter(std::make_shared<RateLimiter>(0)),
+      m_job_queue(worker_count)
+{
+}
+
+HasherVec HashEngine::generate_hasher_vec(const std::vector<std::string> &hasher_names)
+{
+    HasherVec hasher_vec;
+    for (const auto &name : hasher_names)
+    {
+        if (name == "MD5")
+        {
+            hasher_vec.push_back({name, std::make_shared<ciftl::MD5Hasher>()});
+        }
+        else if (name == "Sha1")
+        {
+            hasher_vec.push_back({name, std::make_shared<ciftl::Sha1Hasher>()});
+        }
+        else if (name == "Sha256")
+        {
+            hasher_vec.push_back({name, std::make_shared<ciftl::Sha256Hasher>()});
+        }
+        else if (name == "Sha512")
+        {
+            hasher_vec.push_back({name, std::make_shared<ciftl::Sha512Hasher>()});
+        }
+    }
+    return hasher_vec;
+}
+
+FileReadStatus HashEngine::digest_file(FileReader &reader, const std::vector<std::string> &hasher_names,
+                                       const std::string &file_path, const std::function<bool(size_t)> &on_block,
+                                       std::vector<std::pair<std::string, std::string>> &digests)
+{
+    auto hasher_vec = generate_hasher_vec(hasher_names);
+    size_t sum = 0;
+    // 边读取边计算hash
+    auto status = reader.read(file_path, [&](const uint8_t *data, size_t cnt)
+                              {
+        for (auto iter : hasher_vec)
+        {
+            iter.second->update(data, cnt);
+        }
+        sum += cnt;
+        return on_block(sum); });
+    if (status == FileReadStatus::OK)
+    {
+        // 以十六进制格式输出
+        for (auto iter : hasher_vec)
+        {
+            auto res = iter.second->finalize();
+            digests.push_back({iter.first, HexCodec::encode(res)});
+        }
+    }
+    return status;
+}
+
+void HashEngine::cached_digests(const std::string &key, uint64_t size, int64_t mtime,
+                                std::map<std::string, std::string> &digests)
+{
+    auto iter = m_cache.find(key);
+    if (iter == m_cache.end())
+    {
+        return;
+    }
+    if (iter->second.size != size || iter->second.mtime != mtime)
+    {
+        // 文件已经改变，缓存作废
+        m_lru.erase(iter->second.lru);
+        m_cache.erase(iter);
+        return;
+    }
+    m_lru.splice(m_lru.begin(), m_lru, iter->second.lru);
+    digests.insert(iter->second.digests.begin(), iter->second.digests.end());
+}
+
+void HashEngine::store_digests(const std::string &key, uint64_t size, int64_t mtime,
+                               const std::vector<std::pair<std::string, std::string>> &digests)
+{
+    auto iter = m_cache.find(key);
+    if (iter != m_cache.end() && (iter->second.size != size || iter->second.mtime != mtime))
+    {
+        m_lru.erase(iter->second.lru);
+        m_cache.erase(iter);
+        iter = m_cache.end();
+    }
+    if (iter == m_cache.end())
+    {
+        if (m_cache.size() >= m_cache_capacity)
+        {
+            m_cache.erase(m_lru.back());
+            m_lru.pop_back();
+        }
+        m_lru.push_front(key);
+        iter = m_cache.emplace(key, CacheEntry()).first;
+        iter->second.size = size;
+        iter->second.mtime = mtime;
+        iter->second.lru = m_lru.begin();
+    }
+    for (const auto &digest : digests)
+    {
+        iter->second.digests[digest.first] = digest.second;
+    }
+}
+
+void HashEngine::update_rate_limit()
+{
+    m_rate_limiter->set_rate(m_rate_limits.empty() ? 0 : *m_rate_limits.begin());
+}
+
+void HashEngine::hash_one(FileReader &reader, JobControl &control, const DeviceGroup &group,
+                          const std::vector<std::string> &hasher_names, const std::string &file_path,
+                          const std::function<void(size_t)> &on_progress, HashResult &result)
+{
+    int64_t mtime;
+    if (!HashManifest::file_stat(file_path, result.size, mtime))
+    {
+        result.status = FileReadStatus::OPEN_FAILED;
+        return;
+    }
+    std::error_code ec;
+    std::string key = std::filesystem::weakly_canonical(file_path, ec).string();
+    if (ec)
+    {
+        key = file_path;
+    }
+    std::map<std::string, std::string> digests;
+    std::vector<std::string> missing;
+    std::shared_ptr<InFlight> own;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;)
+        {
+            cached_digests(key, result.size, mtime, digests);
+            missing.clear();
+            for (const auto &name : hasher_names)
+            {
+                if (!digests.count(name))
+                {
+                    missing.push_back(name);
+                }
+            }
+            if (missing.empty())
+            {
+                break;
+            }
+            // 正在进行的读取能覆盖缺少的算法时等待它完成，否则自己读取
+            std::shared_ptr<InFlight> other;
+            for (const auto &in_flight : m_in_flight[key])
+            {
+                // 普通任务在紧急任务运行期间让出，紧急任务等待普通任务的读取会互相等待
+                if (in_flight->size == result.size && in_flight->mtime == mtime &&
+                    (control.priority() == JobPriority::NORMAL || in_flight->priority == JobPriority::URGENT) &&
+                    std::all_of(missing.begin(), missing.end(), [&](const std::string &name)
+                                { return std::find(in_flight->hasher_names.begin(), in_flight->hasher_names.end(),
+                                                   name) != in_flight->hasher_names.end(); }))
+                {
+                    other = in_flight;
+                    break;
+                }
+            }
+            if (!other)
+            {
+                own = std::make_shared<InFlight>();
+                own->size = result.size;
+                own->mtime = mtime;
+                own->hasher_names = missing;
+                own->priority = control.priority();
+                m_in_flight[key].push_back(own);
+                break;
+            }
+            // 对方失败或被取消时重新检查，必要时自己读取
+            while (!other->done)
+            {
+                // 暂停时检查点会阻塞，不能持有锁
+                lock.unlock();
+                bool running = control.checkpoint();
+                lock.lock();
+                if (!running)
+                {
+                    result.status = FileReadStatus::CANCELLED;
+                    return;
+                }
+                m_cv.wait_for(lock, std::chrono::milliseconds(100), [&]()
+                              { return other->done; });
+            }
+        }
+    }
+    result.shared = !own;
+    if (own)
+    {
+        const size_t lanes = IoScheduler::device_lanes(group.kind, IoScheduler::__default_solid_state_lanes__);
+        const bool urgent = control.priority() == JobPriority::URGENT;
+        auto cancelled = [&]()
+        { return control.cancelled(); };
+        std::vector<std::pair<std::string, std::string>> computed;
+        if (!m_device_gate.acquire(group.device, lanes, urgent, cancelled))
+        {
+            result.status = FileReadStatus::CANCELLED;
+        }
+        else
+        {
+            bool holding = true;
+            result.status = digest_file(reader, missing, file_path, [&](size_t sum)
+                                        {
+                on_progress((size_t)(100.0 * sum / result.size));
+                // 每读完一块让出设备通道，暂停时不占用通道，其他请求可以在两块之间读取
+                m_device_gate.release(group.device);
+                holding = false;
+                // 暂停时在这里阻塞，取消后读完当前块即停止
+                if (!control.checkpoint())
+                {
+                    return false;
+                }
+                holding = m_device_gate.acquire(group.device, lanes, urgent, cancelled);
+                return holding; }, computed);
+            if (holding)
+            {
+                m_device_gate.release(group.device);
+            }
+            result.note = reader.note();
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (result.status == FileReadStatus::OK)
+        {
+            store_digests(key, result.size, mtime, computed);
+            digests.insert(computed.begin(), computed.end());
+        }
+        auto &in_flights = m_in_flight[key];
+        in_flights.erase(std::find(in_flights.begin(), in_flights.end(), own));
+        if (in_flights.empty())
+        {
+            m_in_flight.erase(key);
+        }
+        own->done = true;
+        m_cv.notify_all();
+    }
+    if (result.status == FileReadStatus::OK)
+    {
+        for (const auto &name : hasher_names)
+        {
+            result.digests.push_back({name, digests[name]});
+        }
+    }
+}
+
+std::shared_ptr<JobControl> HashEngine::submit(const HashRequest &request, const HashCallback &callback)
+{
+    JobTask func = [this, request, callback](JobControl &control)
+    {
+        FileReadOption read_option;
+        read_option.mode = request.mode;
+        read_option.rate_limiter = m_rate_limiter;
+        read_option.cancelled = [&control]()
+        { return control.cancelled(); };
+        if (request.rate_limit)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_rate_limits.insert(request.rate_limit);
+            update_rate_limit();
+        }
+        // 按所在磁盘分组，不同磁盘并行读取
+        IoScheduler scheduler(request.file_paths);
+        if (scheduler.lane_count() > 1)
+        {
+            read_option.block_size = 1024 * 1024 * 8;
+        }
+        std::vector<std::unique_ptr<FileReader>> readers(scheduler.lane_count());
+        std::mutex callback_mutex;
+        scheduler.run([&](size_t lane, size_t i, size_t next)
+                      {
+            if (control.cancelled())
+            {
+                return;
+            }
+            if (!readers[lane])
+            {
+                readers[lane] = std::make_unique<FileReader>(read_option);
+            }
+            readers[lane]->prefetch(next != IoScheduler::__no_file__ ? request.file_paths[next] : "");
+            HashResult result;
+            result.index = i;
+            hash_one(*readers[lane], control, scheduler.group_of(lane), request.hasher_names, request.file_paths[i],
+                     [&](size_t percent)
+                     {
+                std::lock_guard<std::mutex> lock(callback_mutex);
+                callback.on_progress(percent); }, result);
+            std::lock_guard<std::mutex> lock(callback_mutex);
+            callback.on_result(result); });
+        if (request.rate_limit)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_rate_limits.erase(m_rate_limits.find(request.rate_limit));
+            update_rate_limit();
+        }
+        callback.on_end();
+    };
+    return m_job_queue.submit(func, request.priority);
+}
+
+void HashEngine::cancel_all()
+{
+    m_job_queue.cancel_all();
+}
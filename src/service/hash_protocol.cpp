@@ -0,0 +1,149 @@
+#include <vector>
+
+#include "service/field_codec.h"
+#include "service/hash_protocol.h"
+
+namespace
+{
+    bool parse_number(const std::string &str, uint64_t &value)
+    {
+        // stoull接受前导空白和负号，负数会被转换为很大的正数
+        if (str.empty() || str[0] < '0' || str[0] > '9')
+        {
+            return false;
+        }
+        try
+        {
+            size_t pos;
+            value = std::stoull(str, &pos);
+            return pos == str.size();
+        }
+        catch (const std::exception &)
+        {
+            return false;
+        }
+    }
+
+    std::vector<std::string> split_names(const std::string &str)
+    {
+        std::vector<std::string> names;
+        size_t start = 0;
+        for (size_t pos; (pos = str.find(',', start)) != std::string::npos; start = pos + 1)
+        {
+            names.push_back(str.substr(start, pos - start));
+        }
+        if (start < str.size())
+        {
+            names.push_back(str.substr(start));
+        }
+        return names;
+    }
+}
+
+std::string HashProtocol::encode_request(const HashRequest &request)
+{
+    std::string names;
+    for (const auto &name : request.hasher_names)
+    {
+        names += names.empty() ? name : "," + name;
+    }
+    std::vector<std::string> fields = {"hash", std::to_string((int)request.priority), std::to_string((int)request.mode),
+                                       std::to_string(request.rate_limit), names};
+    fields.insert(fields.end(), request.file_paths.begin(), request.file_paths.end());
+    return FieldCodec::join(fields);
+}
+
+bool HashProtocol::decode_request(const std::string &line, HashRequest &request)
+{
+    std::vector<std::string> fields;
+    uint64_t priority, mode;
+    if (!FieldCodec::split(line, fields) || fields.size() < 5 || fields[0] != "hash" ||
+        !parse_number(fields[1], priority) || priority > (uint64_t)JobPriority::NORMAL ||
+        !parse_number(fields[2], mode) || mode > (uint64_t)FileReadMode::ASYNC ||
+        !parse_number(fields[3], request.rate_limit))
+    {
+        return false;
+    }
+    request.priority = (JobPriority)priority;
+    request.mode = (FileReadMode)mode;
+    request.hasher_names = split_names(fields[4]);
+    request.file_paths.assign(fields.begin() + 5, fields.end());
+    return true;
+}
+
+std::string HashProtocol::encode_progress(size_t percent)
+{
+    return FieldCodec::join({"progress", std::to_string(percent)});
+}
+
+std::string HashProtocol::encode_result(const HashResult &result)
+{
+    std::vector<std::string> fields = {"result", std::to_string(result.index), std::to_string((int)result.status),
+                                       std::to_string(result.size), result.shared ? "1" : "0", result.note};
+    for (const auto &digest : result.digests)
+    {
+        fields.push_back(digest.first + "=" + digest.second);
+    }
+    return FieldCodec::join(fields);
+}
+
+std::string HashProtocol::encode_error(const std::string &message)
+{
+    return FieldCodec::join({"error", message});
+}
+
+std::string HashProtocol::encode_end()
+{
+    return "end";
+}
+
+bool HashProtocol::decode_reply(const std::string &line, HashReplyKind &kind, size_t &percent, HashResult &result,
+                                std::string &message)
+{
+    std::vector<std::string> fields;
+    if (!FieldCodec::split(line, fields))
+    {
+        return false;
+    }
+    uint64_t value;
+    if (fields[0] == "progress" && fields.size() == 2 && parse_number(fields[1], value))
+    {
+        kind = HashReplyKind::PROGRESS;
+        percent = (size_t)value;
+        return true;
+    }
+    if (fields[0] == "error" && fields.size() == 2)
+    {
+        kind = HashReplyKind::FAILED;
+        message = fields[1];
+        return true;
+    }
+    if (fields[0] == "end" && fields.size() == 1)
+    {
+        kind = HashReplyKind::END;
+        return true;
+    }
+    uint64_t index, status;
+    if (fields[0] != "result" || fields.size() < 6 || !parse_number(fields[1], index) ||
+        !parse_number(fields[2], status) || status > (uint64_t)FileReadStatus::CANCELLED ||
+        !parse_number(fields[3], result.size) || (fields[4] != "0" && fields[4] != "1"))
+    {
+        return false;
+    }
+    kind = HashReplyKind::RESULT;
+    result.index = (size_t)index;
+    result.status = (FileReadStatus)status;
+    result.shared = fields[4] == "1";
+    result.note = fields[5];
+    result.digests.clear();
+    for (size_t i = 6; i < fields.size(); i++)
+    {
+        size_t eq = fields[i].find('=');
+        if (eq == std::string::npos)
+        {
+            return false;
+        }
+        result.digests.push_back({fields[i].substr(0, eq), fields[i].substr(eq + 1)});
+    }
+    return true;
+}
@@ -0,0 +1,237 @@
+#ifdef __linux__
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#endif
+
+#include "service/unix_socket.h"
+
+UnixSocket::UnixSocket(int fd) : m_fd(fd)
+{
+}
+
+int UnixSocket::fd() const
+{
+    return m_fd;
+}
+
+#ifdef __linux__
+namespace
+{
+    bool make_address(const std::string &path, struct sockaddr_un &addr, std::string &message)
+    {
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path))
+        {
+            message = "套接字路径过长：" + path;
+            return false;
+        }
+        std::memcpy(addr.sun_path, path.c_str(), path.size());
+        return true;
+    }
+}
+
+UnixSocket::~UnixSocket()
+{
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+    }
+}
+
+bool UnixSocket::connect(const std::string &path, std::string &message)
+{
+    struct sockaddr_un addr;
+    if (!make_address(path, addr, message))
+    {
+        return false;
+    }
+    m_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_fd < 0 || ::connect(m_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        message = "无法连接：" + path + "，" + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool UnixSocket::listen(const std::string &path, std::string &message)
+{
+    struct sockaddr_un addr;
+    if (!make_address(path, addr, message))
+    {
+        return false;
+    }
+    // 能连上说明已有进程在监听，否则是上次异常退出留下的文件
+    UnixSocket probe;
+    std::string probe_message;
+    if (probe.connect(path, probe_message))
+    {
+        message = "已有进程在监听：" + path;
+        return false;
+    }
+    ::unlink(path.c_str());
+    m_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    // 创建时即只允许当前用户访问，不给其他用户留下连接的时间窗口
+    mode_t mask = ::umask(0077);
+    bool ok = m_fd >= 0 && ::bind(m_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+    ::umask(mask);
+    if (!ok || ::listen(m_fd, SOMAXCONN) < 0)
+    {
+        message = "无法监听：" + path + "，" + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+int UnixSocket::accept(int wake_fd)
+{
+    for (;;)
+    {
+        struct pollfd fds[2] = {{m_fd, POLLIN, 0}, {wake_fd, POLLIN, 0}};
+        if (::poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        if (fds[1].revents & POLLIN)
+        {
+            return -1;
+        }
+        int fd = ::accept4(m_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd >= 0)
+        {
+            return fd;
+        }
+        if (errno != EINTR && errno != ECONNABORTED && errno != EAGAIN)
+        {
+            return -1;
+        }
+    }
+}
+
+bool UnixSocket::send_line(const std::string &line)
+{
+    std::string data = line + "\n";
+    for (size_t sent = 0; sent < data.size();)
+    {
+        // 对端已关闭时不产生SIGPIPE
+        ssize_t n = ::send(m_fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+bool UnixSocket::read_line(std::string &line, int timeout_ms, bool &timed_out, size_t max_size)
+{
+    timed_out = false;
+    for (;;)
+    {
+        size_t pos = m_buffer.find('\n');
+        if (pos != std::string::npos)
+        {
+            line = m_buffer.substr(0, pos);
+            m_buffer.erase(0, pos + 1);
+            return true;
+        }
+        if (m_buffer.size() > max_size)
+        {
+            return false;
+        }
+        struct pollfd pfd = {m_fd, POLLIN, 0};
+        int ret = ::poll(&pfd, 1, timeout_ms);
+        if (ret < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (ret == 0)
+        {
+            timed_out = true;
+            return false;
+        }
+        char buf[64 * 1024];
+        ssize_t n = ret < 0 ? -1 : ::recv(m_fd, buf, sizeof(buf), 0);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        m_buffer.append(buf, (size_t)n);
+    }
+}
+
+bool UnixSocket::same_user() const
+{
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    return ::getsockopt(m_fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 && cred.uid == ::geteuid();
+}
+
+void UnixSocket::shutdown()
+{
+    if (m_fd >= 0)
+    {
+        ::shutdown(m_fd, SHUT_RDWR);
+    }
+}
+#else
+UnixSocket::~UnixSocket()
+{
+}
+
+bool UnixSocket::connect(const std::string &path, std::string &message)
+{
+    message = "守护进程只支持Linux";
+    return false;
+}
+
+bool UnixSocket::listen(const std::string &path, std::string &message)
+{
+    message = "守护进程只支持Linux";
+    return false;
+}
+
+int UnixSocket::accept(int wake_fd)
+{
+    return -1;
+}
+
+bool UnixSocket::send_line(const std::string &line)
+{
+    return false;
+}
+
+bool UnixSocket::read_line(std::string &line, int timeout_ms, bool &timed_out, size_t max_size)
+{
+    timed_out = false;
+    return false;
+}
+
+bool UnixSocket::same_user() const
+{
+    return false;
+}
+
+void UnixSocket::shutdown()
+{
+}
+#endif
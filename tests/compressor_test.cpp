@@ -0,0 +1,86 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "cryption/compressor.h"
+
+namespace
+{
+    // 结构相同、内容不同的短文本，适合训练字典
+    std::vector<std::string> samples(size_t count, const std::string &tag)
+    {
+        std::vector<std::string> res;
+        for (size_t i = 0; i < count; i++)
+        {
+            res.push_back("{\"id\":" + std::to_string(i) + ",\"name\":\"" + tag + std::to_string(i * 7919 % 1000) +
+                          "\",\"roles\":[\"admin\",\"reader\"],\"enabled\":true,\"config\":{\"theme\":\"dark\"}}");
+        }
+        return res;
+    }
+
+    std::string train(const std::string &tag)
+    {
+        std::string message;
+        std::string dictionary = Compressor::train_dictionary(samples(500, tag), 8 * 1024, message);
+        EXPECT_FALSE(dictionary.empty()) << message;
+        return dictionary;
+    }
+
+    const uint8_t *bytes(const std::string &str)
+    {
+        return (const uint8_t *)str.data();
+    }
+}
+
+TEST(CompressorTest, RoundTrip)
+{
+    Compressor compressor;
+    std::string text(10000, 'a');
+    std::string frame, plain, message;
+    ASSERT_TRUE(compressor.compress(bytes(text), text.size(), frame));
+    EXPECT_LT(frame.size(), text.size());
+    ASSERT_TRUE(compressor.decompress(bytes(frame), frame.size(), text.size(), plain, message)) << message;
+    EXPECT_EQ(plain, text);
+    // 超过上限的原文视为错误
+    EXPECT_FALSE(compressor.decompress(bytes(frame), frame.size(), text.size() - 1, plain, message));
+}
+
+TEST(CompressorTest, DictionaryRoundTrip)
+{
+    std::string dictionary = train("user");
+    std::string message;
+    ASSERT_TRUE(Compressor::check_dictionary(dictionary, message)) << message;
+    Compressor with_dictionary(Compressor::__default_level__, dictionary);
+    Compressor without_dictionary;
+    EXPECT_NE(with_dictionary.dictionary_id(), 0u);
+    EXPECT_EQ(without_dictionary.dictionary_id(), 0u);
+    // 训练集之外的同类短文本，使用字典后明显更短
+    std::string text = samples(1000, "user").back();
+    std::string frame, plain_frame, plain;
+    ASSERT_TRUE(with_dictionary.compress(bytes(text), text.size(), frame));
+    if (without_dictionary.compress(bytes(text), text.size(), plain_frame))
+    {
+        EXPECT_LT(frame.size(), plain_frame.size());
+    }
+    ASSERT_TRUE(with_dictionary.decompress(bytes(frame), frame.size(), text.size(), plain, message)) << message;
+    EXPECT_EQ(plain, text);
+    // 帧头记录了字典ID，没有字典或字典不同时解压失败
+    EXPECT_FALSE(without_dictionary.decompress(bytes(frame), frame.size(), text.size(), plain, message));
+    Compressor other_dictionary(Compressor::__default_level__, train("other"));
+    ASSERT_NE(other_dictionary.dictionary_id(), with_dictionary.dictionary_id());
+    EXPECT_FALSE(other_dictionary.decompress(bytes(frame), frame.size(), text.size(), plain, message));
+}
+
+TEST(CompressorTest, CheckDictionary)
+{
+    std::string message;
+    // 没有ID的原始内容字典
+    EXPECT_FALSE(Compressor::check_dictionary(std::string(2000, 'x'), message));
+    EXPECT_FALSE(message.empty());
+    // 魔数和ID完整但内容被截断
+    std::string dictionary = train("user");
+    message.clear();
+    EXPECT_FALSE(Compressor::check_dictionary(dictionary.substr(0, 16), message));
+    EXPECT_FALSE(message.empty());
+}
@@ -0,0 +1,232 @@
+#include <random>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <filesystem>
+
+#include <gtest/gtest.h>
+
+#include "cryption/file_crypter.h"
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    std::vector<uint8_t> read_file(const fs::path &path)
+    {
+        std::ifstream ifs(path, std::ios::in | std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(ifs), {});
+    }
+
+    void write_file(const fs::path &path, const std::vector<uint8_t> &data)
+    {
+        std::ofstream ofs(path, std::ios::out | std::ios::binary);
+        ofs.write((const char *)data.data(), data.size());
+    }
+
+    // 前半段可以压缩，后半段是随机数据，两种数据块都会出现
+    std::vector<uint8_t> sample_data(size_t size)
+    {
+        std::vector<uint8_t> data(size);
+        std::mt19937 rng((uint32_t)size);
+        for (size_t i = 0; i < size; i++)
+        {
+            data[i] = i < size / 2 ? (uint8_t)("hello world "[i % 12]) : (uint8_t)rng();
+        }
+        return data;
+    }
+
+    class FileCrypterTest : public ::testing::TestWithParam<bool>
+    {
+    protected:
+        void SetUp() override
+        {
+            // 参数化测试的名称中含有'/'
+            std::string name = ::testing::UnitTest::GetInstance()->current_test_info()->name();
+            std::replace(name.begin(), name.end(), '/', '_');
+            m_dir = fs::temp_directory_path() / ("ciftl_gui_file_crypter_" + name);
+            fs::remove_all(m_dir);
+            fs::create_directories(m_dir);
+            m_option.chunk_size = FileCrypter::__min_chunk_size__;
+            m_option.thread_count = 3;
+            m_option.compress = GetParam();
+        }
+
+        void TearDown() override
+        {
+            std::error_code ec;
+            fs::remove_all(m_dir, ec);
+        }
+
+        // 加密sample_data(size)，返回密文的路径
+        fs::path encrypt(size_t size, const std::string &password = "password")
+        {
+            write_file(m_dir / "plain", sample_data(size));
+            FileCrypter crypter(password, m_option);
+            auto result = crypter.encrypt_file((m_dir / "plain").string(), (m_dir / "cipher").string());
+            EXPECT_TRUE(result.ok) << result.message;
+            return m_dir / "cipher";
+        }
+
+        FileCrypterResult decrypt(const std::string &password = "password")
+        {
+            FileCrypter crypter(password, m_option);
+            return crypter.decrypt_file((m_dir / "cipher").string(), (m_dir / "decrypted").string());
+        }
+
+        void flip_byte(const fs::path &path, std::streamoff offset)
+        {
+            std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekg(offset);
+            char c = (char)file.get();
+            file.seekp(offset);
+            file.put((char)(c ^ 1));
+        }
+
+        fs::path m_dir;
+        FileCrypterOption m_option;
+    };
+}
+
+TEST_P(FileCrypterTest, RoundTrip)
+{
+    for (auto algorithm : {CipherAlgorithm::ChaCha20, CipherAlgorithm::AES256OFB, CipherAlgorithm::SM4OFB})
+    {
+        m_option.algorithm = algorithm;
+        // 空文件、恰好一块、多出一个字节和多块的情况
+        for (size_t size : {(size_t)0, (size_t)1, m_option.chunk_size, m_option.chunk_size + 1, (size_t)300000})
+        {
+            auto cipher = encrypt(size);
+            auto header = read_file(cipher);
+            ASSERT_GE(header.size(), (size_t)9);
+            // 文件头记录了容器版本
+            EXPECT_EQ(header[8], m_option.compress ? FileCrypter::__compressed_container_version__
+                                                   : FileCrypter::__container_version__);
+            auto result = decrypt();
+            ASSERT_TRUE(result.ok) << result.message;
+            EXPECT_EQ(read_file(m_dir / "decrypted"), sample_data(size)) << "size " << size;
+        }
+    }
+}
+
+TEST_P(FileCrypterTest, WrongPassword)
+{
+    encrypt(10000);
+    EXPECT_FALSE(decrypt("another password").ok);
+    EXPECT_FALSE(fs::exists(m_dir / "decrypted"));
+}
+
+TEST_P(FileCrypterTest, TamperedChunk)
+{
+    auto cipher = encrypt(300000);
+    flip_byte(cipher, (std::streamoff)fs::file_size(cipher) / 2);
+    EXPECT_FALSE(decrypt().ok);
+    // 认证失败时不留下解密了一半的文件
+    EXPECT_FALSE(fs::exists(m_dir / "decrypted"));
+}
+
+TEST_P(FileCrypterTest, TamperedHeader)
+{
+    // chunk_size、kdf_iterations和salt都在header_mac的保护范围内
+    for (std::streamoff offset : {12, 16, 30})
+    {
+        auto cipher = encrypt(10000);
+        flip_byte(cipher, offset);
+        EXPECT_FALSE(decrypt().ok) << "offset " << offset;
+    }
+}
+
+TEST_P(FileCrypterTest, Truncated)
+{
+    auto cipher = encrypt(300000);
+    fs::resize_file(cipher, fs::file_size(cipher) - 10);
+    EXPECT_FALSE(decrypt().ok);
+    // 去掉整个最后一块也必须被发现
+    encrypt(300000);
+    fs::resize_file(cipher, fs::file_size(cipher) - m_option.chunk_size);
+    EXPECT_FALSE(decrypt().ok);
+}
+
+TEST_P(FileCrypterTest, Appended)
+{
+    auto cipher = encrypt(300000);
+    {
+        std::ofstream ofs(cipher, std::ios::out | std::ios::binary | std::ios::app);
+        ofs.put(0);
+    }
+    EXPECT_FALSE(decrypt().ok);
+}
+
+TEST_P(FileCrypterTest, DecryptRange)
+{
+    const size_t size = 300000;
+    encrypt(size);
+    auto plain = sample_data(size);
+    FileCrypter crypter("password", m_option);
+    const uint64_t chunk = m_option.chunk_size;
+    // 从块中间开始并跨越块边界、恰好一块、跨越多块、文件末尾和超出末尾的区间
+    const std::pair<uint64_t, uint64_t> ranges[] = {
+        {3 * chunk + 1000, chunk + 500},
+        {5 * chunk, chunk},
+        {chunk - 1, 4 * chunk + 2},
+        {size - 100, 100},
+        {size - 10, 1000},
+        {0, size},
+    };
+    for (const auto &[offset, length] : ranges)
+    {
+        std::vector<uint8_t> out;
+        auto result = crypter.decrypt_range((m_dir / "cipher").string(), offset, length, out);
+        ASSERT_TRUE(result.ok) << result.message;
+        uint64_t end = std::min<uint64_t>(offset + length, size);
+        EXPECT_EQ(out, std::vector<uint8_t>(plain.begin() + offset, plain.begin() + end))
+            << "offset " << offset << ", length " << length;
+    }
+    std::vector<uint8_t> out;
+    ASSERT_TRUE(crypter.decrypt_range((m_dir / "cipher").string(), size, 10, out).ok);
+    EXPECT_TRUE(out.empty());
+    EXPECT_FALSE(FileCrypter("another password", m_option).decrypt_range((m_dir / "cipher").string(), 0, 10, out).ok);
+}
+
+TEST_P(FileCrypterTest, DecryptRangeTampered)
+{
+    const size_t size = 300000;
+    auto cipher = encrypt(size);
+    const uint64_t chunk_count = (size + m_option.chunk_size - 1) / m_option.chunk_size;
+    const uint64_t index_length = m_option.compress ? chunk_count * 8 : 0;
+    // 最后一块认证码的最后一个字节
+    flip_byte(cipher, (std::streamoff)(fs::file_size(cipher) - index_length - 1));
+    FileCrypter crypter("password", m_option);
+    std::vector<uint8_t> out;
+    // 只读取需要的块，不涉及被篡改的块时仍然成功
+    auto result = crypter.decrypt_range(cipher.string(), m_option.chunk_size + 10, m_option.chunk_size, out);
+    ASSERT_TRUE(result.ok) << result.message;
+    EXPECT_EQ(out.size(), m_option.chunk_size);
+    // 区间的最后一块被篡改时不输出任何明文
+    EXPECT_FALSE(crypter.decrypt_range(cipher.string(), size - m_option.chunk_size - 10, m_option.chunk_size, out).ok);
+    EXPECT_TRUE(out.empty());
+}
+
+TEST_P(FileCrypterTest, TamperedIndex)
+{
+    if (!m_option.compress)
+    {
+        GTEST_SKIP() << "只有压缩容器有块偏移索引";
+    }
+    const size_t size = 300000;
+    auto cipher = encrypt(size);
+    const uint64_t chunk_count = (size + m_option.chunk_size - 1) / m_option.chunk_size;
+    // 第二块的偏移
+    flip_byte(cipher, (std::streamoff)(fs::file_size(cipher) - (chunk_count - 1) * 8));
+    EXPECT_FALSE(decrypt().ok);
+    FileCrypter crypter("password", m_option);
+    std::vector<uint8_t> out;
+    EXPECT_FALSE(crypter.decrypt_range(cipher.string(), m_option.chunk_size, 10, out).ok);
+    EXPECT_TRUE(out.empty());
+}
+
+INSTANTIATE_TEST_SUITE_P(Container, FileCrypterTest, ::testing::Values(false, true),
+                         [](const ::testing::TestParamInfo<bool> &info)
+                         { return info.param ? "Compressed" : "Plain"; });
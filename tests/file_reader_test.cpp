@@ -0,0 +1,136 @@
+#include <random>
+#include <string>
+#include <chrono>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+
+#include <gtest/gtest.h>
+
+#include "io/file_reader.h"
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    class FileReaderTest : public ::testing::TestWithParam<FileReadMode>
+    {
+    protected:
+        void SetUp() override
+        {
+            m_root = fs::temp_directory_path() / ("ciftl_gui_reader_" + std::to_string((int)GetParam()));
+            fs::remove_all(m_root);
+            fs::create_directories(m_root);
+            // 空文件、不足一块、恰好整块和跨越多个队列深度的文件
+            const size_t block = FileReader::__async_block_size__;
+            const size_t sizes[] = {0, 1000, block, block * FileReader::__async_queue_depth__ * 2 + 12345, 77777};
+            std::mt19937 rng(1);
+            for (size_t i = 0; i < std::size(sizes); i++)
+            {
+                std::string content(sizes[i], '\0');
+                for (auto &c : content)
+                {
+                    c = (char)rng();
+                }
+                std::string path = (m_root / ("f" + std::to_string(i))).string();
+                std::ofstream(path, std::ios::out | std::ios::binary) << content;
+                m_paths.push_back(path);
+                m_contents.push_back(content);
+            }
+        }
+
+        void TearDown() override
+        {
+            std::error_code ec;
+            fs::remove_all(m_root, ec);
+        }
+
+        FileReadOption option() const
+        {
+            FileReadOption option;
+            option.mode = GetParam();
+            option.block_size = 256 * 1024;
+            return option;
+        }
+
+        // 读取整个文件，stop_after块之后取消
+        FileReadStatus read(FileReader &reader, const std::string &path, std::string &content,
+                            size_t stop_after = SIZE_MAX)
+        {
+            content.clear();
+            size_t blocks = 0;
+            return reader.read(path, [&](const uint8_t *data, size_t len)
+                               {
+                content.append((const char *)data, len);
+                return ++blocks < stop_after; });
+        }
+
+        fs::path m_root;
+        std::vector<std::string> m_paths;
+        std::vector<std::string> m_contents;
+    };
+}
+
+TEST_P(FileReaderTest, Sequential)
+{
+    FileReader reader(option());
+    for (size_t i = 0; i < m_paths.size(); i++)
+    {
+        std::string content;
+        ASSERT_EQ(read(reader, m_paths[i], content), FileReadStatus::OK) << m_paths[i];
+        EXPECT_EQ(content, m_contents[i]) << m_paths[i];
+    }
+}
+
+TEST_P(FileReaderTest, Prefetch)
+{
+    FileReader reader(option());
+    for (size_t i = 0; i < m_paths.size(); i++)
+    {
+        reader.prefetch(i + 1 < m_paths.size() ? m_paths[i + 1] : "");
+        std::string content;
+        ASSERT_EQ(read(reader, m_paths[i], content), FileReadStatus::OK) << m_paths[i];
+        EXPECT_EQ(content, m_contents[i]) << m_paths[i];
+    }
+}
+
+TEST_P(FileReaderTest, PrefetchNotUsed)
+{
+    FileReader reader(option());
+    std::string content;
+    // 预读的文件没有被读取，或在读取前被取消
+    reader.prefetch(m_paths[3]);
+    ASSERT_EQ(read(reader, m_paths[2], content), FileReadStatus::OK);
+    ASSERT_EQ(read(reader, m_paths[4], content), FileReadStatus::OK);
+    EXPECT_EQ(content, m_contents[4]);
+    reader.prefetch(m_paths[4]);
+    EXPECT_EQ(read(reader, m_paths[3], content, 2), FileReadStatus::CANCELLED);
+    ASSERT_EQ(read(reader, m_paths[4], content), FileReadStatus::OK);
+    EXPECT_EQ(content, m_contents[4]);
+    // 预读不存在的文件不影响当前文件
+    reader.prefetch((m_root / "missing").string());
+    ASSERT_EQ(read(reader, m_paths[3], content), FileReadStatus::OK);
+    EXPECT_EQ(content, m_contents[3]);
+    EXPECT_EQ(read(reader, (m_root / "missing").string(), content), FileReadStatus::OPEN_FAILED);
+    // 预读之后直接析构
+    reader.prefetch(m_paths[3]);
+    ASSERT_EQ(read(reader, m_paths[1], content), FileReadStatus::OK);
+}
+
+TEST_P(FileReaderTest, CancelDuringRateLimit)
+{
+    // 每块都要等待数秒，取消后应在一个检查间隔左右返回
+    FileReadOption option = this->option();
+    option.rate_limiter = std::make_shared<RateLimiter>(64 * 1024);
+    auto start = std::chrono::steady_clock::now();
+    option.cancelled = [start]()
+    { return std::chrono::steady_clock::now() - start > std::chrono::milliseconds(200); };
+    FileReader reader(option);
+    std::string content;
+    EXPECT_EQ(read(reader, m_paths[3], content), FileReadStatus::CANCELLED);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}
+
+INSTANTIATE_TEST_SUITE_P(Mode, FileReaderTest,
+                         ::testing::Values(FileReadMode::BUFFERED, FileReadMode::BULK_SCAN, FileReadMode::DIRECT,
+                                           FileReadMode::ASYNC));
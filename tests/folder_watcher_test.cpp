@@ -0,0 +1,188 @@
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+
+#include <gtest/gtest.h>
+
+#include "io/folder_watcher.h"
+#include "io/hash_manifest.h"
+
+namespace
+{
+    namespace fs = std::filesystem;
+    using clock_type = std::chrono::steady_clock;
+
+    class FolderWatcherTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            m_root = fs::temp_directory_path() /
+                     (std::string("ciftl_gui_watcher_") +
+                      ::testing::UnitTest::GetInstance()->current_test_info()->name());
+            fs::remove_all(m_root);
+            fs::create_directories(m_root);
+        }
+
+        void TearDown() override
+        {
+            if (m_watcher)
+            {
+                m_watcher->stop();
+                m_thread.join();
+            }
+            std::error_code ec;
+            fs::remove_all(m_root, ec);
+        }
+
+        // 在后台线程中收集变化及收到的时间
+        void start()
+        {
+            m_watcher = std::make_unique<FolderWatcher>(m_root.string());
+            std::string message;
+            ASSERT_TRUE(m_watcher->start(message)) << message;
+            m_thread = std::thread([this]()
+                                   {
+                std::vector<FileChange> changes;
+                while (m_watcher->wait_changes(changes))
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    for (const auto &change : changes)
+                    {
+                        m_changes.push_back({change, clock_type::now()});
+                    }
+                } });
+        }
+
+        void append(const std::string &path, const std::string &text)
+        {
+            std::ofstream(m_root / path, std::ios::out | std::ios::binary | std::ios::app) << text;
+        }
+
+        // 等待path累计出现times次kind类型的变化，超时返回false
+        bool wait_change(const std::string &path, FileChangeKind kind, size_t times = 1)
+        {
+            auto deadline = clock_type::now() + std::chrono::seconds(5);
+            while (clock_type::now() < deadline)
+            {
+                if (count(path, kind) >= times)
+                {
+                    return true;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            return false;
+        }
+
+        size_t count(const std::string &path, FileChangeKind kind)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return std::count_if(m_changes.begin(), m_changes.end(), [&](const auto &item)
+                                 { return item.first.path == path && item.first.kind == kind; });
+        }
+
+        clock_type::time_point first_time(const std::string &path)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const auto &[change, time] : m_changes)
+            {
+                if (change.path == path)
+                {
+                    return time;
+                }
+            }
+            return clock_type::time_point::max();
+        }
+
+        fs::path m_root;
+        std::unique_ptr<FolderWatcher> m_watcher;
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::vector<std::pair<FileChange, clock_type::time_point>> m_changes;
+    };
+}
+
+TEST_F(FolderWatcherTest, DebounceBurst)
+{
+    start();
+    // 连续写入期间不报告，写入停止debounce时间后只报告一次
+    for (int i = 0; i < 8; i++)
+    {
+        append("a", std::string(1000, 'x'));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    auto last_write = clock_type::now();
+    ASSERT_TRUE(wait_change("a", FileChangeKind::MODIFIED));
+    EXPECT_GE(first_time("a") - last_write, std::chrono::milliseconds(400));
+    std::this_thread::sleep_for(std::chrono::milliseconds(700));
+    EXPECT_EQ(count("a", FileChangeKind::MODIFIED), 1u);
+}
+
+TEST_F(FolderWatcherTest, MetadataChange)
+{
+    append("a", "text");
+    start();
+    // 只修改修改时间，不写入内容
+    fs::last_write_time(m_root / "a", fs::file_time_type::clock::now() - std::chrono::hours(1));
+    EXPECT_TRUE(wait_change("a", FileChangeKind::MODIFIED));
+}
+
+TEST_F(FolderWatcherTest, NewSubdirectory)
+{
+    start();
+    // 新目录及其中随后创建的文件都被监视
+    fs::create_directories(m_root / "d" / "e");
+    append("d/e/x", "text");
+    ASSERT_TRUE(wait_change("d/e/x", FileChangeKind::MODIFIED));
+    append("d/y", "text");
+    EXPECT_TRUE(wait_change("d/y", FileChangeKind::MODIFIED));
+    append("d/e/x", "more");
+    EXPECT_TRUE(wait_change("d/e/x", FileChangeKind::MODIFIED, 2));
+}
+
+TEST_F(FolderWatcherTest, RemoveDirectory)
+{
+    fs::create_directories(m_root / "d" / "e");
+    append("d/e/x", "text");
+    append("d/y", "text");
+    append("dx", "text");
+    HashManifest manifest(m_root.string());
+    std::string message;
+    ASSERT_TRUE(manifest.load(message)) << message;
+    for (const std::string &path : {"d/e/x", "d/y", "dx"})
+    {
+        ManifestEntry entry;
+        ASSERT_TRUE(HashManifest::file_stat((m_root / path).string(), entry.size, entry.mtime));
+        ASSERT_TRUE(manifest.update(path, entry, message)) << message;
+    }
+    start();
+    fs::remove_all(m_root / "d");
+    ASSERT_TRUE(wait_change("d", FileChangeKind::REMOVED));
+    // 目录被删除时报告目录本身，清单删除整个子树，不影响同前缀的dx
+    std::vector<FileChange> changes;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto &item : m_changes)
+        {
+            changes.push_back(item.first);
+        }
+    }
+    for (const auto &change : changes)
+    {
+        if (change.kind == FileChangeKind::REMOVED)
+        {
+            ASSERT_TRUE(manifest.remove(change.path, message)) << message;
+        }
+    }
+    EXPECT_EQ(manifest.paths(), (std::vector<std::string>{"dx"}));
+    // 删除后重新创建的同名目录重新加入监视
+    fs::create_directories(m_root / "d");
+    append("d/z", "text");
+    EXPECT_TRUE(wait_change("d/z", FileChangeKind::MODIFIED));
+}
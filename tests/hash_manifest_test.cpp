@@ -0,0 +1,168 @@
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+
+#include <gtest/gtest.h>
+
+#include "io/hash_manifest.h"
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    ManifestEntry make_entry(uint64_t size, int64_t mtime)
+    {
+        ManifestEntry entry;
+        entry.size = size;
+        entry.mtime = mtime;
+        entry.digests = {{"MD5", "d41d8cd98f00b204e9800998ecf8427e"}, {"Sha1", std::to_string(size)}};
+        return entry;
+    }
+
+    class HashManifestTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            m_root = fs::temp_directory_path() /
+                     (std::string("ciftl_gui_manifest_") +
+                      ::testing::UnitTest::GetInstance()->current_test_info()->name());
+            fs::remove_all(m_root);
+            fs::create_directories(m_root);
+        }
+
+        void TearDown() override
+        {
+            std::error_code ec;
+            fs::remove_all(m_root, ec);
+        }
+
+        fs::path snapshot_path() const
+        {
+            return m_root / HashManifest::__manifest_name__;
+        }
+
+        fs::path journal_path() const
+        {
+            return m_root / (std::string(HashManifest::__manifest_name__) + HashManifest::__journal_suffix__);
+        }
+
+        // 从磁盘重新加载一个清单
+        std::vector<std::string> reload_paths()
+        {
+            HashManifest manifest(m_root.string());
+            std::string message;
+            EXPECT_TRUE(manifest.load(message)) << message;
+            return manifest.paths();
+        }
+
+        fs::path m_root;
+    };
+}
+
+TEST_F(HashManifestTest, JournalReplay)
+{
+    HashManifest manifest(m_root.string());
+    std::string message;
+    ASSERT_TRUE(manifest.load(message)) << message;
+    EXPECT_EQ(manifest.size(), 0u);
+    // 路径中的制表符、换行符和反斜杠需要转义
+    const std::string odd_path = "odd\tname\nwith\\slash";
+    for (const auto &path : std::vector<std::string>{"a", "d/x", "d/y", "dx", "d.txt", odd_path})
+    {
+        ASSERT_TRUE(manifest.update(path, make_entry(path.size(), 1), message)) << message;
+    }
+    // 覆盖之前的记录
+    ASSERT_TRUE(manifest.update("a", make_entry(100, 2), message)) << message;
+    // 删除目录d下的记录，不影响同前缀的dx和d.txt
+    ASSERT_TRUE(manifest.remove("d", message)) << message;
+    EXPECT_TRUE(fs::exists(journal_path()));
+    EXPECT_FALSE(fs::exists(snapshot_path()));
+
+    HashManifest reloaded(m_root.string());
+    ASSERT_TRUE(reloaded.load(message)) << message;
+    EXPECT_EQ(reloaded.paths(), manifest.paths());
+    EXPECT_EQ(reloaded.paths(), (std::vector<std::string>{"a", "d.txt", "dx", odd_path}));
+    EXPECT_TRUE(reloaded.up_to_date("a", 100, 2));
+    EXPECT_FALSE(reloaded.up_to_date("a", 1, 1));
+    EXPECT_TRUE(reloaded.up_to_date(odd_path, odd_path.size(), 1));
+}
+
+TEST_F(HashManifestTest, CompactThenJournal)
+{
+    HashManifest manifest(m_root.string());
+    std::string message;
+    ASSERT_TRUE(manifest.load(message)) << message;
+    ASSERT_TRUE(manifest.update("a", make_entry(1, 1), message)) << message;
+    ASSERT_TRUE(manifest.update("b", make_entry(2, 2), message)) << message;
+    ASSERT_TRUE(manifest.compact(message)) << message;
+    EXPECT_TRUE(fs::exists(snapshot_path()));
+    EXPECT_FALSE(fs::exists(journal_path()));
+    // 快照之后的修改记在日志中，加载时重放在快照之上
+    ASSERT_TRUE(manifest.remove("a", message)) << message;
+    ASSERT_TRUE(manifest.update("c", make_entry(3, 3), message)) << message;
+    EXPECT_TRUE(fs::exists(journal_path()));
+    EXPECT_EQ(reload_paths(), (std::vector<std::string>{"b", "c"}));
+}
+
+TEST_F(HashManifestTest, AutoCompact)
+{
+    HashManifest manifest(m_root.string());
+    std::string message;
+    ASSERT_TRUE(manifest.load(message)) << message;
+    // 同一个文件反复修改，日志行数达到下限后重写快照
+    for (size_t i = 0; i < HashManifest::__min_compact_lines__; i++)
+    {
+        ASSERT_TRUE(manifest.update("a", make_entry(i, (int64_t)i), message)) << message;
+    }
+    EXPECT_TRUE(fs::exists(snapshot_path()));
+    EXPECT_FALSE(fs::exists(journal_path()));
+    HashManifest reloaded(m_root.string());
+    ASSERT_TRUE(reloaded.load(message)) << message;
+    size_t last = HashManifest::__min_compact_lines__ - 1;
+    EXPECT_TRUE(reloaded.up_to_date("a", last, (int64_t)last));
+}
+
+TEST_F(HashManifestTest, TornLastLine)
+{
+    {
+        HashManifest manifest(m_root.string());
+        std::string message;
+        ASSERT_TRUE(manifest.load(message)) << message;
+        ASSERT_TRUE(manifest.update("a", make_entry(1, 1), message)) << message;
+    }
+    // 崩溃时最后一行只写了一半
+    {
+        std::ofstream ofs(journal_path(), std::ios::out | std::ios::binary | std::ios::app);
+        ofs << "+\tb\t2";
+    }
+    HashManifest manifest(m_root.string());
+    std::string message;
+    ASSERT_TRUE(manifest.load(message)) << message;
+    EXPECT_EQ(manifest.paths(), (std::vector<std::string>{"a"}));
+    // 加载时已经重写快照，之后追加的记录不会接在半行后面
+    ASSERT_TRUE(manifest.update("c", make_entry(3, 3), message)) << message;
+    EXPECT_EQ(reload_paths(), (std::vector<std::string>{"a", "c"}));
+}
+
+TEST_F(HashManifestTest, CorruptSnapshot)
+{
+    {
+        std::ofstream ofs(snapshot_path(), std::ios::out | std::ios::binary);
+        ofs << "not a manifest\n";
+    }
+    HashManifest manifest(m_root.string());
+    std::string message;
+    EXPECT_FALSE(manifest.load(message));
+    EXPECT_FALSE(message.empty());
+}
+
+TEST_F(HashManifestTest, ManifestFileNames)
+{
+    EXPECT_TRUE(HashManifest::is_manifest_file(snapshot_path().filename().string()));
+    EXPECT_TRUE(HashManifest::is_manifest_file(journal_path().filename().string()));
+    EXPECT_TRUE(HashManifest::is_manifest_file(std::string(HashManifest::__manifest_name__) +
+                                               HashManifest::__temp_suffix__));
+    EXPECT_FALSE(HashManifest::is_manifest_file("manifest.txt"));
+}
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "service/field_codec.h"
+#include "service/hash_protocol.h"
+
+TEST(FieldCodecTest, RoundTrip)
+{
+    const std::vector<std::vector<std::string>> cases = {
+        {""},
+        {"", ""},
+        {"plain", "two words"},
+        {"tab\there", "new\nline", "carriage\rreturn", "back\\slash", "\\t literal"},
+        {"\t\t", "\\", "\n"},
+    };
+    for (const auto &fields : cases)
+    {
+        std::string line = FieldCodec::join(fields);
+        // 一行之内不能出现换行符，字段之间只有分隔用的制表符
+        EXPECT_EQ(line.find('\n'), std::string::npos);
+        EXPECT_EQ(line.find('\r'), std::string::npos);
+        EXPECT_EQ((size_t)std::count(line.begin(), line.end(), '\t'), fields.size() - 1);
+        std::vector<std::string> decoded;
+        ASSERT_TRUE(FieldCodec::split(line, decoded)) << line;
+        EXPECT_EQ(decoded, fields);
+    }
+}
+
+TEST(FieldCodecTest, InvalidEscape)
+{
+    std::vector<std::string> fields;
+    EXPECT_FALSE(FieldCodec::split("trailing\\", fields));
+    EXPECT_FALSE(FieldCodec::split("bad\\x", fields));
+}
+
+TEST(HashProtocolTest, RequestRoundTrip)
+{
+    HashRequest request;
+    request.file_paths = {"/tmp/a b", "/tmp/tab\tname", "/tmp/new\nline", "/tmp/back\\slash"};
+    request.hasher_names = {"MD5", "Sha256"};
+    request.mode = FileReadMode::DIRECT;
+    request.rate_limit = 123456789;
+    request.priority = JobPriority::URGENT;
+    std::string line = HashProtocol::encode_request(request);
+    EXPECT_EQ(line.find('\n'), std::string::npos);
+    HashRequest decoded;
+    ASSERT_TRUE(HashProtocol::decode_request(line, decoded));
+    EXPECT_EQ(decoded.file_paths, request.file_paths);
+    EXPECT_EQ(decoded.hasher_names, request.hasher_names);
+    EXPECT_EQ(decoded.mode, request.mode);
+    EXPECT_EQ(decoded.rate_limit, request.rate_limit);
+    EXPECT_EQ(decoded.priority, request.priority);
+}
+
+TEST(HashProtocolTest, InvalidRequest)
+{
+    HashRequest request;
+    for (const std::string &line : {std::string(""), std::string("hash\t1\t0\t0"), std::string("get\t1\t0\t0\tMD5"),
+                                    std::string("hash\tx\t0\t0\tMD5"), std::string("hash\t1\t9\t0\tMD5"),
+                                    std::string("hash\t9\t0\t0\tMD5"), std::string("hash\t1\t0\t-1\tMD5"),
+                                    std::string("hash\t1\t0\t0\tMD5\tbad\\q")})
+    {
+        EXPECT_FALSE(HashProtocol::decode_request(line, request)) << line;
+    }
+}
+
+TEST(HashProtocolTest, ReplyRoundTrip)
+{
+    HashReplyKind kind;
+    size_t percent = 0;
+    HashResult result;
+    std::string message;
+
+    ASSERT_TRUE(HashProtocol::decode_reply(HashProtocol::encode_progress(42), kind, percent, result, message));
+    EXPECT_EQ(kind, HashReplyKind::PROGRESS);
+    EXPECT_EQ(percent, 42u);
+
+    HashResult expected;
+    expected.index = 7;
+    expected.status = FileReadStatus::OK;
+    expected.size = 1ULL << 40;
+    expected.shared = true;
+    expected.note = "io_uring不可用，已改用缓冲读取";
+    expected.digests = {{"MD5", "d41d8cd98f00b204e9800998ecf8427e"}, {"Sha1", "da39a3ee5e6b4b0d3255bfef95601890afd80709"}};
+    ASSERT_TRUE(HashProtocol::decode_reply(HashProtocol::encode_result(expected), kind, percent, result, message));
+    EXPECT_EQ(kind, HashReplyKind::RESULT);
+    EXPECT_EQ(result.index, expected.index);
+    EXPECT_EQ(result.status, expected.status);
+    EXPECT_EQ(result.size, expected.size);
+    EXPECT_EQ(result.shared, expected.shared);
+    EXPECT_EQ(result.note, expected.note);
+    EXPECT_EQ(result.digests, expected.digests);
+
+    // 失败的文件没有摘要
+    expected.status = FileReadStatus::OPEN_FAILED;
+    expected.shared = false;
+    expected.note.clear();
+    expected.digests.clear();
+    ASSERT_TRUE(HashProtocol::decode_reply(HashProtocol::encode_result(expected), kind, percent, result, message));
+    EXPECT_EQ(result.status, FileReadStatus::OPEN_FAILED);
+    EXPECT_FALSE(result.shared);
+    EXPECT_TRUE(result.note.empty());
+    EXPECT_TRUE(result.digests.empty());
+
+    ASSERT_TRUE(HashProtocol::decode_reply(HashProtocol::encode_error("无法打开\t文件\n"), kind, percent, result,
+                                           message));
+    EXPECT_EQ(kind, HashReplyKind::FAILED);
+    EXPECT_EQ(message, "无法打开\t文件\n");
+
+    ASSERT_TRUE(HashProtocol::decode_reply(HashProtocol::encode_end(), kind, percent, result, message));
+    EXPECT_EQ(kind, HashReplyKind::END);
+}
+
+TEST(HashProtocolTest, InvalidReply)
+{
+    HashReplyKind kind;
+    size_t percent;
+    HashResult result;
+    std::string message;
+    for (const std::string &line :
+         {std::string(""), std::string("progress"), std::string("progress\tx"), std::string("end\textra"),
+          std::string("result\t0\t0\t10\t0"), std::string("result\t0\t9\t10\t0\t"),
+          std::string("result\t0\t0\t10\t2\t"), std::string("result\t-1\t0\t10\t0\t"),
+          std::string("result\t0\t0\t10\t0\t\tMD5")})
+    {
+        EXPECT_FALSE(HashProtocol::decode_reply(line, kind, percent, result, message)) << line;
+    }
+}
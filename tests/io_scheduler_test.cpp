@@ -0,0 +1,232 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#include <linux/fiemap.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include "io/io_scheduler.h"
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+#ifdef __linux__
+    // 文件第一个extent的物理偏移，与IoScheduler的判断方式相同
+    bool first_extent(const std::string &path, uint64_t &offset)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+        alignas(struct fiemap) uint8_t buf[sizeof(struct fiemap) + sizeof(struct fiemap_extent)] = {};
+        struct fiemap *map = (struct fiemap *)buf;
+        map->fm_length = FIEMAP_MAX_OFFSET;
+        map->fm_extent_count = 1;
+        bool ok = ::ioctl(fd, FS_IOC_FIEMAP, map) == 0 && map->fm_mapped_extents > 0;
+        offset = ok ? map->fm_extents[0].fe_physical : 0;
+        ::close(fd);
+        return ok;
+    }
+#endif
+
+    class IoSchedulerTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            m_root = fs::temp_directory_path() / "ciftl_gui_scheduler";
+            fs::remove_all(m_root);
+            fs::create_directories(m_root);
+            // 交替写入大小不同的文件，使物理位置的顺序与文件名和inode的顺序不一定相同
+            for (size_t i = 0; i < 8; i++)
+            {
+                std::string path = (m_root / ("f" + std::to_string(i))).string();
+                std::ofstream(path, std::ios::out | std::ios::binary) << std::string((i % 3 + 1) * 50000, (char)i);
+                m_paths.push_back(path);
+            }
+            std::reverse(m_paths.begin() + 2, m_paths.end());
+        }
+
+        void TearDown() override
+        {
+            std::error_code ec;
+            fs::remove_all(m_root, ec);
+        }
+
+        fs::path m_root;
+        std::vector<std::string> m_paths;
+    };
+
+    // 等待后台线程进入排队状态
+    void settle()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    const auto never = []()
+    { return false; };
+}
+
+TEST(DeviceGateTest, LaneLimit)
+{
+    DeviceGate gate;
+    ASSERT_TRUE(gate.acquire(1, 2, false, never));
+    ASSERT_TRUE(gate.acquire(1, 2, false, never));
+    // 其他设备不受影响
+    ASSERT_TRUE(gate.acquire(2, 1, false, never));
+    std::atomic<bool> acquired(false);
+    std::thread waiter([&]()
+                       {
+        gate.acquire(1, 2, false, never);
+        acquired = true; });
+    settle();
+    EXPECT_FALSE(acquired);
+    gate.release(1);
+    waiter.join();
+    EXPECT_TRUE(acquired);
+    gate.release(1);
+    gate.release(1);
+    gate.release(2);
+}
+
+TEST(DeviceGateTest, UrgentFirst)
+{
+    DeviceGate gate;
+    ASSERT_TRUE(gate.acquire(1, 1, false, never));
+    std::mutex mutex;
+    std::vector<int> order;
+    auto worker = [&](int id, bool urgent)
+    {
+        return std::thread([&, id, urgent]()
+                           {
+            gate.acquire(1, 1, urgent, never);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                order.push_back(id);
+            }
+            gate.release(1); });
+    };
+    // 普通的等待者先到，紧急的等待者仍然先获得通道；同一优先级按到达顺序
+    std::thread normal1 = worker(1, false);
+    settle();
+    std::thread normal2 = worker(2, false);
+    settle();
+    std::thread urgent = worker(3, true);
+    settle();
+    gate.release(1);
+    normal1.join();
+    normal2.join();
+    urgent.join();
+    EXPECT_EQ(order, (std::vector<int>{3, 1, 2}));
+}
+
+TEST(DeviceGateTest, CancelWhileWaiting)
+{
+    DeviceGate gate;
+    ASSERT_TRUE(gate.acquire(1, 1, false, never));
+    std::atomic<bool> cancelled(false);
+    std::atomic<int> result(-1);
+    std::thread waiter([&]()
+                       { result = gate.acquire(1, 1, false, [&]()
+                                               { return cancelled.load(); }); });
+    settle();
+    cancelled = true;
+    waiter.join();
+    EXPECT_EQ(result, 0);
+    // 放弃排队的等待者不会挡住后来者
+    gate.release(1);
+    EXPECT_TRUE(gate.acquire(1, 1, false, never));
+    gate.release(1);
+}
+
+TEST_F(IoSchedulerTest, OneDeviceOneGroup)
+{
+    auto paths = m_paths;
+    paths.insert(paths.begin() + 3, (m_root / "missing").string());
+    IoScheduler scheduler(paths);
+    // 存在的文件都在同一块磁盘上，另有一组无法访问的文件
+    ASSERT_EQ(scheduler.groups().size(), 2u);
+    const DeviceGroup &group = scheduler.groups()[0];
+    EXPECT_EQ(group.files.size(), m_paths.size());
+    EXPECT_EQ(scheduler.groups()[1].files, std::vector<size_t>{3});
+    EXPECT_LE(group.lanes, IoScheduler::device_lanes(group.kind, IoScheduler::__default_solid_state_lanes__));
+    EXPECT_EQ(scheduler.lane_count(), group.lanes + scheduler.groups()[1].lanes);
+#ifdef __linux__
+    if (group.kind == DeviceKind::ROTATIONAL)
+    {
+        // 机械硬盘只有一条通道，按物理偏移排序
+        EXPECT_EQ(group.lanes, 1u);
+        std::vector<uint64_t> offsets;
+        for (size_t index : group.files)
+        {
+            uint64_t offset;
+            if (first_extent(paths[index], offset))
+            {
+                offsets.push_back(offset);
+            }
+        }
+        EXPECT_TRUE(std::is_sorted(offsets.begin(), offsets.end()));
+    }
+    else
+    {
+        std::vector<uint64_t> inodes;
+        for (size_t index : group.files)
+        {
+            struct stat st;
+            ASSERT_EQ(::stat(paths[index].c_str(), &st), 0);
+            inodes.push_back(st.st_ino);
+        }
+        EXPECT_TRUE(std::is_sorted(inodes.begin(), inodes.end()));
+    }
+#endif
+}
+
+TEST_F(IoSchedulerTest, RunVisitsEveryFileOnce)
+{
+    IoScheduler scheduler(m_paths);
+    ASSERT_EQ(scheduler.groups().size(), 1u);
+    const DeviceGroup &group = scheduler.groups()[0];
+    std::mutex mutex;
+    std::vector<std::vector<std::pair<size_t, size_t>>> visits(scheduler.lane_count());
+    scheduler.run([&](size_t lane, size_t index, size_t next)
+                  {
+        std::lock_guard<std::mutex> lock(mutex);
+        ASSERT_LT(lane, visits.size());
+        visits[lane].push_back({index, next}); });
+    std::vector<size_t> visited;
+    for (const auto &lane : visits)
+    {
+        for (size_t k = 0; k < lane.size(); k++)
+        {
+            visited.push_back(lane[k].first);
+            // 告知的下一个文件正是该通道接着处理的文件
+            EXPECT_EQ(lane[k].second, k + 1 < lane.size() ? lane[k + 1].first : IoScheduler::__no_file__);
+        }
+    }
+    if (group.lanes == 1)
+    {
+        // 单通道按组内的顺序读取
+        EXPECT_EQ(visited, group.files);
+    }
+    std::sort(visited.begin(), visited.end());
+    std::vector<size_t> all(m_paths.size());
+    for (size_t i = 0; i < all.size(); i++)
+    {
+        all[i] = i;
+    }
+    EXPECT_EQ(visited, all);
+}
@@ -0,0 +1,153 @@
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+
+#include <gtest/gtest.h>
+
+#include "etc/job_queue.h"
+
+namespace
+{
+    // 轮询等待条件成立，超时返回false
+    bool wait_until(const std::function<bool()> &pred)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!pred())
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    // 记录任务开始的顺序
+    class StartOrder
+    {
+    public:
+        void push(const std::string &name)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_names.push_back(name);
+        }
+
+        std::vector<std::string> names() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_names;
+        }
+
+    private:
+        mutable std::mutex m_mutex;
+        std::vector<std::string> m_names;
+    };
+}
+
+TEST(JobQueueTest, UrgentRunsWhileNormalYields)
+{
+    JobQueue queue;
+    std::atomic<size_t> progress = 0;
+    std::atomic<bool> stop = false;
+    std::atomic<bool> normal_done = false;
+    queue.submit([&](JobControl &control)
+                 {
+        while (!stop && control.checkpoint())
+        {
+            progress++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        normal_done = true; });
+    ASSERT_TRUE(wait_until([&]()
+                           { return progress > 0; }));
+
+    // 紧急任务运行期间普通任务停在检查点处，进度不变
+    std::atomic<bool> urgent_done = false;
+    size_t before = 0, after = 0;
+    queue.submit([&](JobControl &)
+                 {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        before = progress;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        after = progress;
+        urgent_done = true; },
+                 JobPriority::URGENT);
+    ASSERT_TRUE(wait_until([&]()
+                           { return urgent_done.load(); }));
+    EXPECT_EQ(before, after);
+    EXPECT_FALSE(normal_done);
+
+    // 紧急任务结束后普通任务继续
+    ASSERT_TRUE(wait_until([&]()
+                           { return progress > after; }));
+    stop = true;
+    ASSERT_TRUE(wait_until([&]()
+                           { return normal_done.load(); }));
+}
+
+TEST(JobQueueTest, CancelAllReleasesPaused)
+{
+    JobQueue queue;
+    std::atomic<bool> running = false;
+    std::atomic<int> checkpoint_result = -1;
+    queue.submit([&](JobControl &control)
+                 {
+        running = true;
+        while (control.checkpoint())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        checkpoint_result = 0; });
+    ASSERT_TRUE(wait_until([&]()
+                           { return running.load(); }));
+    queue.pause();
+    EXPECT_TRUE(queue.paused());
+
+    // 暂停期间排队的任务不开始
+    std::atomic<size_t> queued_runs = 0;
+    std::atomic<bool> queued_cancelled = false;
+    auto queued = queue.submit([&](JobControl &control)
+                               {
+        queued_cancelled = control.cancelled();
+        queued_runs++; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(queued_runs, 0u);
+    EXPECT_EQ(checkpoint_result, -1);
+
+    // 取消后停在检查点的任务返回，排队的任务以已取消状态执行一次
+    queue.cancel_all();
+    EXPECT_FALSE(queue.paused());
+    ASSERT_TRUE(wait_until([&]()
+                           { return checkpoint_result == 0 && queued_runs == 1; }));
+    EXPECT_TRUE(queued_cancelled);
+    EXPECT_TRUE(queued->cancelled());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(queued_runs, 1u);
+}
+
+TEST(JobQueueTest, PauseResumeOrder)
+{
+    JobQueue queue;
+    StartOrder order;
+    queue.pause();
+    queue.submit([&](JobControl &)
+                 { order.push("A"); });
+    queue.submit([&](JobControl &)
+                 { order.push("B"); });
+    queue.submit([&](JobControl &)
+                 { order.push("U"); },
+                 JobPriority::URGENT);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_TRUE(order.names().empty());
+
+    // 恢复后紧急任务先开始，普通任务保持提交顺序
+    queue.resume();
+    ASSERT_TRUE(wait_until([&]()
+                           { return order.names().size() == 3; }));
+    EXPECT_EQ(order.names(), (std::vector<std::string>{"U", "A", "B"}));
+}
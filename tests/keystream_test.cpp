@@ -0,0 +1,79 @@
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "cryption/keystream.h"
+
+namespace
+{
+    std::vector<uint8_t> random_bytes(size_t size, uint32_t seed)
+    {
+        std::vector<uint8_t> data(size);
+        std::mt19937 rng(seed);
+        for (auto &b : data)
+        {
+            b = (uint8_t)rng();
+        }
+        return data;
+    }
+
+    // 单线程的结果作为参照，多线程切分后的输出必须逐字节相同
+    void expect_same_as_sequential(CipherAlgorithm algorithm, const std::vector<uint8_t> &iv, size_t size)
+    {
+        auto key = random_bytes(32, 1);
+        auto plain = random_bytes(size, (uint32_t)size);
+        auto expected = plain;
+        ASSERT_TRUE(KeystreamCipher(algorithm, key.data(), 1).apply(iv.data(), expected.data(), expected.size()));
+        for (size_t threads : {2, 3, 8})
+        {
+            auto actual = plain;
+            KeystreamCipher cipher(algorithm, key.data(), threads);
+            ASSERT_TRUE(cipher.apply(iv.data(), actual.data(), actual.size()));
+            EXPECT_EQ(actual, expected) << "size " << size << ", threads " << threads;
+            // 流密码再运算一次即还原
+            ASSERT_TRUE(cipher.apply(iv.data(), actual.data(), actual.size()));
+            EXPECT_EQ(actual, plain) << "size " << size << ", threads " << threads;
+        }
+    }
+}
+
+TEST(KeystreamTest, ChaCha20SplitMatchesSequential)
+{
+    auto iv = random_bytes(16, 2);
+    // 计数器从0开始，切分点按64字节的块对齐
+    iv[0] = iv[1] = iv[2] = iv[3] = 0;
+    const size_t threshold = KeystreamCipher::__chacha20_parallel_threshold__;
+    for (size_t size : {threshold - 1, threshold, threshold + 63, (size_t)5 * 1024 * 1024 + 17})
+    {
+        expect_same_as_sequential(CipherAlgorithm::ChaCha20, iv, size);
+    }
+}
+
+TEST(KeystreamTest, ChaCha20CounterOffset)
+{
+    auto iv = random_bytes(16, 3);
+    // 非零的起始计数器
+    iv[0] = 7;
+    iv[1] = iv[2] = iv[3] = 0;
+    expect_same_as_sequential(CipherAlgorithm::ChaCha20, iv, 1024 * 1024 + 5);
+    // 计数器即将溢出时不切分，结果也必须一致
+    iv[0] = 0xf0;
+    iv[1] = iv[2] = iv[3] = 0xff;
+    expect_same_as_sequential(CipherAlgorithm::ChaCha20, iv, 1024 * 1024 + 5);
+}
+
+TEST(KeystreamTest, OfbPipelineMatchesSequential)
+{
+    auto iv = random_bytes(16, 4);
+    const size_t threshold = KeystreamCipher::__ofb_pipeline_threshold__;
+    const size_t slot = KeystreamCipher::__ofb_pipeline_slot__;
+    for (auto algorithm : {CipherAlgorithm::AES128OFB, CipherAlgorithm::AES256OFB, CipherAlgorithm::SM4OFB})
+    {
+        // 恰好整槽、不足一槽的尾部和不是分组长度整数倍的尾部
+        for (size_t size : {threshold - 1, threshold, threshold + slot / 2 + 3, (size_t)3 * 1024 * 1024 + 1})
+        {
+            expect_same_as_sequential(algorithm, iv, size);
+        }
+    }
+}
@@ -0,0 +1,120 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <ciftl/crypter/crypter.h>
+
+#include "cryption/compressor.h"
+#include "cryption/string_pipeline.h"
+
+namespace
+{
+    std::shared_ptr<ciftl::IStringCrypter> make_crypter()
+    {
+        return std::make_shared<ciftl::StringCrypter<ciftl::ChaCha20CipherAlgorithm>>();
+    }
+
+    // 大量结构相同的短文本，另加空行、单字符和长文本
+    std::vector<CrypterTableData> sample_rows()
+    {
+        std::vector<CrypterTableData> rows;
+        for (int i = 0; i < 200; i++)
+        {
+            rows.emplace_back("{\"id\":" + std::to_string(i) + ",\"name\":\"user" + std::to_string(i * 7919 % 1000) +
+                              "\",\"roles\":[\"admin\",\"reader\"],\"enabled\":true,\"config\":{\"theme\":\"dark\"}}");
+        }
+        rows.emplace_back("");
+        rows.emplace_back("x");
+        rows.emplace_back(std::string(100000, 'a'));
+        return rows;
+    }
+
+    std::vector<CrypterTableData> encrypt(const std::vector<CrypterTableData> &rows, const StringCompressOption &option)
+    {
+        auto encrypted = rows;
+        StringPipeline(make_crypter, "password", option, 3).encrypt(encrypted);
+        return encrypted;
+    }
+
+    std::vector<CrypterTableData> decrypt(const std::vector<CrypterTableData> &encrypted,
+                                          const StringCompressOption &option)
+    {
+        std::vector<CrypterTableData> decrypted;
+        for (const auto &row : encrypted)
+        {
+            decrypted.emplace_back(row.res_text);
+        }
+        StringPipeline(make_crypter, "password", option, 3).decrypt(decrypted);
+        return decrypted;
+    }
+
+    void expect_round_trip(const StringCompressOption &option)
+    {
+        auto rows = sample_rows();
+        auto decrypted = decrypt(encrypt(rows, option), option);
+        ASSERT_EQ(decrypted.size(), rows.size());
+        for (size_t i = 0; i < rows.size(); i++)
+        {
+            EXPECT_EQ(decrypted[i].res_text, rows[i].src_text) << "row " << i << ": " << decrypted[i].res_mes;
+        }
+    }
+
+    std::string train_dictionary()
+    {
+        std::vector<std::string> samples;
+        for (const auto &row : sample_rows())
+        {
+            samples.push_back(row.src_text);
+        }
+        std::string message;
+        std::string dictionary = Compressor::train_dictionary(samples, 8 * 1024, message);
+        EXPECT_FALSE(dictionary.empty()) << message;
+        return dictionary;
+    }
+
+    bool is_compressed(const CrypterTableData &row)
+    {
+        return row.res_text.rfind(StringPipeline::__compressed_prefix__, 0) == 0;
+    }
+}
+
+TEST(StringPipelineTest, RoundTrip)
+{
+    expect_round_trip(StringCompressOption());
+}
+
+TEST(StringPipelineTest, CompressedRoundTrip)
+{
+    StringCompressOption option;
+    option.enabled = true;
+    expect_round_trip(option);
+    // 长文本压缩，单个字符没有收益，不加前缀
+    auto encrypted = encrypt(sample_rows(), option);
+    EXPECT_TRUE(is_compressed(encrypted.back()));
+    EXPECT_FALSE(is_compressed(encrypted[encrypted.size() - 2]));
+    // 帧直接加密，密文长度与加密同样长度的原文相同，没有额外的编码
+    std::string frame;
+    const std::string &src = encrypted.back().src_text;
+    ASSERT_TRUE(Compressor(option.level).compress((const uint8_t *)src.data(), src.size(), frame));
+    auto res = make_crypter()->encrypt(std::string(frame.size(), 'x'), "password");
+    ASSERT_TRUE(res.is_ok());
+    EXPECT_EQ(encrypted.back().res_text.size(),
+              std::string(StringPipeline::__compressed_prefix__).size() + res.ok().value().size());
+}
+
+TEST(StringPipelineTest, DictionaryRoundTrip)
+{
+    StringCompressOption option;
+    option.enabled = true;
+    option.dictionary = train_dictionary();
+    expect_round_trip(option);
+    // 使用字典后短文本也能压缩
+    auto encrypted = encrypt(sample_rows(), option);
+    EXPECT_TRUE(is_compressed(encrypted.front()));
+    // 解密带字典压缩的密文时没有提供字典，报错而不是输出错误的明文
+    StringCompressOption without_dictionary;
+    without_dictionary.enabled = true;
+    auto decrypted = decrypt(encrypted, without_dictionary);
+    EXPECT_TRUE(decrypted.front().res_text.empty());
+    EXPECT_FALSE(decrypted.front().res_mes.empty());
+}
@@ -0,0 +1,171 @@
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <string_view>
+
+#include <openssl/evp.h>
+#include <gtest/gtest.h>
+#include <ciftl/hash/hash.h>
+#include <ciftl/etc/etc.h>
+
+#include "etc/text_codec.h"
+
+// 同一组用例由ctest在CIFTL_TEXT_CODEC为scalar、ssse3和未设置时各运行一次，覆盖每一级实现
+namespace
+{
+    std::vector<uint8_t> random_bytes(size_t size, uint32_t seed)
+    {
+        std::vector<uint8_t> data(size);
+        std::mt19937 rng(seed);
+        for (auto &b : data)
+        {
+            b = (uint8_t)rng();
+        }
+        return data;
+    }
+
+    std::string reference_hex(const std::vector<uint8_t> &data)
+    {
+        static const char *digits = "0123456789abcdef";
+        std::string res;
+        for (uint8_t b : data)
+        {
+            res += digits[b >> 4];
+            res += digits[b & 15];
+        }
+        return res;
+    }
+
+    std::string reference_base64(const std::vector<uint8_t> &data)
+    {
+        std::string res(4 * ((data.size() + 2) / 3) + 1, '\0');
+        int len = EVP_EncodeBlock((unsigned char *)res.data(), data.data(), (int)data.size());
+        res.resize(len);
+        return res;
+    }
+
+    std::vector<uint8_t> bytes_of(std::string_view text)
+    {
+        return std::vector<uint8_t>(text.begin(), text.end());
+    }
+
+    // 向量实现每次处理几十字节，长度覆盖若干个完整的块和每种尾部
+    constexpr size_t MAX_LENGTH = 300;
+}
+
+TEST(TextCodecTest, Level)
+{
+    const char *env = std::getenv("CIFTL_TEXT_CODEC");
+    std::string_view limit = env ? env : "";
+    if (limit == "scalar")
+    {
+        EXPECT_STREQ(text_codec_level(), "scalar");
+    }
+    else if (limit == "ssse3")
+    {
+        EXPECT_STRNE(text_codec_level(), "avx2");
+    }
+}
+
+TEST(TextCodecTest, HexRoundTrip)
+{
+    for (size_t len = 0; len <= MAX_LENGTH; len++)
+    {
+        auto data = random_bytes(len, (uint32_t)len);
+        std::string text = HexCodec::encode(data);
+        ASSERT_EQ(text, reference_hex(data)) << "length " << len;
+        std::vector<uint8_t> decoded;
+        ASSERT_TRUE(HexCodec::decode(text, decoded)) << "length " << len;
+        EXPECT_EQ(decoded, data) << "length " << len;
+    }
+}
+
+TEST(TextCodecTest, HexDecodeMixedCase)
+{
+    std::vector<uint8_t> decoded;
+    ASSERT_TRUE(HexCodec::decode("00ff7fAbCdEf0123456789abcdefABCDEF00ff7fAbCdEf0123456789abcdefABCDEF", decoded));
+    EXPECT_EQ(HexCodec::encode(decoded), "00ff7fabcdef0123456789abcdefabcdef00ff7fabcdef0123456789abcdefabcdef");
+}
+
+TEST(TextCodecTest, HexDecodeInvalid)
+{
+    std::vector<uint8_t> decoded;
+    EXPECT_FALSE(HexCodec::decode("abc", decoded));
+    // 非法字符出现在向量块内部和标量处理的尾部
+    for (size_t pos : {0, 17, 40, 70, 99})
+    {
+        std::string text = reference_hex(random_bytes(50, 5));
+        for (char bad : {'g', 'G', ' ', '/', ':', '@', '`', '\0', '\xff'})
+        {
+            text[pos] = bad;
+            EXPECT_FALSE(HexCodec::decode(text, decoded)) << "position " << pos << ", char " << (int)bad;
+        }
+    }
+}
+
+TEST(TextCodecTest, HexMatchesCiftl)
+{
+    // 哈希工具输出的摘要曾由ciftl::HexEncoding编码，更换实现后大小写等格式必须保持不变
+    ciftl::HexEncoding hex;
+    for (size_t len : {0, 1, 16, 100})
+    {
+        ciftl::Sha256Hasher hasher;
+        auto data = random_bytes(len, (uint32_t)len);
+        hasher.update(data.data(), data.size());
+        auto digest = hasher.finalize();
+        EXPECT_EQ(HexCodec::encode(digest), hex.encode(digest));
+    }
+}
+
+TEST(TextCodecTest, Base64Vectors)
+{
+    // RFC 4648第10节的测试向量
+    const std::pair<std::string_view, std::string_view> vectors[] = {
+        {"", ""},
+        {"f", "Zg=="},
+        {"fo", "Zm8="},
+        {"foo", "Zm9v"},
+        {"foob", "Zm9vYg=="},
+        {"fooba", "Zm9vYmE="},
+        {"foobar", "Zm9vYmFy"},
+    };
+    for (const auto &[plain, encoded] : vectors)
+    {
+        EXPECT_EQ(Base64Codec::encode(bytes_of(plain)), encoded);
+        std::vector<uint8_t> decoded;
+        ASSERT_TRUE(Base64Codec::decode(encoded, decoded)) << encoded;
+        EXPECT_EQ(decoded, bytes_of(plain));
+    }
+}
+
+TEST(TextCodecTest, Base64RoundTrip)
+{
+    for (size_t len = 0; len <= MAX_LENGTH; len++)
+    {
+        auto data = random_bytes(len, (uint32_t)len + 1000);
+        std::string text = Base64Codec::encode(data);
+        ASSERT_EQ(text, reference_base64(data)) << "length " << len;
+        std::vector<uint8_t> decoded;
+        ASSERT_TRUE(Base64Codec::decode(text, decoded)) << "length " << len;
+        EXPECT_EQ(decoded, data) << "length " << len;
+    }
+}
+
+TEST(TextCodecTest, Base64DecodeInvalid)
+{
+    std::vector<uint8_t> decoded;
+    for (std::string_view text : {"Zg=", "Zg", "Z===", "Zg=a", "=Zg=", "Zm9v=Zg=", "Zh=="})
+    {
+        EXPECT_FALSE(Base64Codec::decode(text, decoded)) << text;
+    }
+    for (size_t pos : {0, 31, 60, 130, 199})
+    {
+        std::string text = reference_base64(random_bytes(150, 6));
+        for (char bad : {'-', '_', ' ', '.', ':', '@', '[', '`', '{', '\0', '\xff'})
+        {
+            text[pos] = bad;
+            EXPECT_FALSE(Base64Codec::decode(text, decoded)) << "position " << pos << ", char " << (int)bad;
+        }
+    }
+}